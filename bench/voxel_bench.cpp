@@ -0,0 +1,1034 @@
+// voxel_bench.cpp
+// Headless storage benchmarks. Build with -DMAGMA_BUILD_BENCH=ON and run ./magma-bench
+// No GL context is created, so nothing here may upload meshes.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <stb_perlin.h>
+
+#include "voxel_world.h"
+#include "sparse_voxel_octree.h"
+#include "sparse_voxel_dag.h"
+#include "morton_hash_map.h"
+#include "chunk_pool.h"
+
+// --- Heap accounting: every allocation carries a small size header ---
+// Atomic because snapshot readers release chunk contents on worker threads
+static std::atomic<size_t> g_liveBytes{ 0 };
+static std::atomic<size_t> g_allocations{ 0 };
+
+void* operator new(std::size_t size) {
+    void* block = std::malloc(size + sizeof(std::max_align_t));
+    if (!block) throw std::bad_alloc();
+    *static_cast<std::size_t*>(block) = size;
+    g_liveBytes += size;
+    ++g_allocations;
+    return static_cast<char*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    void* block = static_cast<char*>(ptr) - sizeof(std::max_align_t);
+    g_liveBytes -= *static_cast<std::size_t*>(block);
+    std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    std::vector<VoxelChunk*> chunksOf(const VoxelWorld& world) {
+        std::vector<VoxelChunk*> list;
+        list.reserve(world.chunks.size());
+        world.chunks.forEach([&](VoxelChunk& chunk) { list.push_back(&chunk); });
+        return list;
+    }
+
+    // The original position key and hash, kept here as the baseline
+    struct VoxelPos {
+        int x, y, z;
+
+        bool operator==(const VoxelPos& other) const {
+            return x == other.x && y == other.y && z == other.z;
+        }
+    };
+
+    struct VoxelHash {
+        std::size_t operator()(const VoxelPos& pos) const {
+            return std::hash<int>()(pos.x) ^ std::hash<int>()(pos.y << 1) ^ std::hash<int>()(pos.z << 2);
+        }
+    };
+
+    // The pre-chunk world layout: one hash node per voxel
+    struct LegacyWorld {
+        std::unordered_map<VoxelPos, Voxel, VoxelHash> voxels;
+
+        void generateTerrain(int width, int depth, int maxHeight) {
+            float scale = 0.1f;
+            for (int x = -width / 2; x < width / 2; ++x)
+                for (int z = -depth / 2; z < depth / 2; ++z) {
+                    float noise = stb_perlin_noise3(x * scale, 0.0f, z * scale, 0, 0, 0);
+                    int height = static_cast<int>((noise + 1.0f) / 2.0f * maxHeight);
+                    for (int y = 0; y <= height; ++y)
+                        voxels[{x, y, z}] = Voxel{};
+                }
+        }
+
+        Voxel* getVoxel(const glm::ivec3& p) {
+            auto it = voxels.find({p.x, p.y, p.z});
+            return it == voxels.end() ? nullptr : &it->second;
+        }
+    };
+
+    std::vector<glm::ivec3> randomProbes(int width, int depth, int maxHeight, size_t count) {
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<int> dx(-width / 2, width / 2 - 1);
+        std::uniform_int_distribution<int> dy(0, maxHeight);
+        std::uniform_int_distribution<int> dz(-depth / 2, depth / 2 - 1);
+        std::vector<glm::ivec3> probes(count);
+        for (auto& p : probes) p = glm::ivec3(dx(rng), dy(rng), dz(rng));
+        return probes;
+    }
+
+    template <typename World>
+    void benchLookups(const char* name, World& world, const std::vector<glm::ivec3>& probes, size_t bytes) {
+        size_t hits = 0;
+        auto start = Clock::now();
+        for (const auto& p : probes) {
+            auto v = world.getVoxel(p);
+            if (v && v->active) ++hits;
+        }
+        double secs = secondsSince(start);
+        std::printf("  %-14s %10.2f MB  %8.1f Mlookups/s  (%zu hits)\n",
+                    name, bytes / (1024.0 * 1024.0), probes.size() / secs / 1e6, hits);
+    }
+
+    void benchWorldStorage(int width, int depth, int maxHeight) {
+        std::printf("World storage %dx%d, maxHeight %d\n", width, depth, maxHeight);
+        auto probes = randomProbes(width, depth, maxHeight, 1'000'000);
+
+        {
+            size_t before = g_liveBytes;
+            LegacyWorld legacy;
+            legacy.generateTerrain(width, depth, maxHeight);
+            benchLookups("unordered_map", legacy, probes, g_liveBytes - before);
+        }
+        {
+            size_t before = g_liveBytes;
+            VoxelWorld world;
+            world.generateTerrain(width, depth, maxHeight);
+            benchLookups("chunked", world, probes, g_liveBytes - before);
+        }
+    }
+
+    void benchChunkBytes(int width, int depth, int maxHeight, bool columnStorage) {
+        VoxelWorld world;
+        world.columnStorage = columnStorage;
+        world.generateTerrain(width, depth, maxHeight);
+
+        size_t totalBytes = 0;
+        size_t widthHistogram[17] = {};
+        size_t storageHistogram[3] = {};
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            totalBytes += chunk->memoryUsage();
+            ++widthHistogram[chunk->getMaterials().bitsPerEntry()];
+            ++storageHistogram[int(chunk->getStorage())];
+        }
+
+        size_t chunkCount = world.chunks.size();
+        std::printf("Chunk bytes %dx%d, maxHeight %d, %s: %zu chunks, %.0f bytes/chunk, %.1f bytes/column (16-bit ids: %zu)\n",
+                    width, depth, maxHeight, columnStorage ? "column runs" : "dense", chunkCount,
+                    double(totalBytes) / chunkCount, double(totalBytes) / chunkCount / (CHUNK_SIZE * CHUNK_SIZE),
+                    sizeof(MaterialId) * CHUNK_VOLUME);
+        std::printf("  uniform %zu, dense %zu, columns %zu\n",
+                    storageHistogram[int(ChunkStorage::Uniform)], storageHistogram[int(ChunkStorage::Dense)],
+                    storageHistogram[int(ChunkStorage::Columns)]);
+        if (columnStorage) return;
+        for (int bits : { 0, 1, 2, 4, 8, 16 })
+            std::printf("  %2d-bit indices: %zu chunks%s\n", bits, widthHistogram[bits],
+                        bits == 0 ? " (uniform)" : "");
+    }
+
+    void benchMeshing(int width, int depth, int maxHeight) {
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+
+        // Uniform air chunks take the no-scan path inside buildMesh
+        double uniformSecs = 0.0, denseSecs = 0.0;
+        size_t uniformCount = 0, borderTriangles = 0;
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            auto start = Clock::now();
+            chunk->buildMesh();
+            double secs = secondsSince(start);
+            if (chunk->isUniform()) { uniformSecs += secs; ++uniformCount; }
+            else denseSecs += secs;
+            borderTriangles += chunk->meshVertexCount() / 2;
+        }
+
+        size_t denseCount = world.chunks.size() - uniformCount;
+        std::printf("Meshing %dx%d, maxHeight %d: %zu uniform chunks %.1f us avg, %zu dense chunks %.1f us avg\n",
+                    width, depth, maxHeight,
+                    uniformCount, uniformCount ? uniformSecs / uniformCount * 1e6 : 0.0,
+                    denseCount, denseCount ? denseSecs / denseCount * 1e6 : 0.0);
+
+        // Again with the neighbours' aprons, as VoxelWorld::draw meshes
+        size_t culledTriangles = 0;
+        auto start = Clock::now();
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            chunk->buildMesh(world.neighboursOf(chunk->getChunkPos()));
+            culledTriangles += chunk->meshVertexCount() / 2;
+        }
+        double culledSecs = secondsSince(start);
+        std::printf("  with neighbours: %.1f us avg per chunk, %zu triangles (%zu with border faces kept)\n",
+                    culledSecs / world.chunks.size() * 1e6, culledTriangles, borderTriangles);
+
+        // Single-voxel edits as projectiles make them: rebuilding only the stale
+        // sections against rebuilding the whole chunk
+        std::vector<VoxelChunk*> surface;
+        for (VoxelChunk* chunk : chunksOf(world))
+            if (chunk->meshVertexCount() != 0) surface.push_back(chunk);
+        std::mt19937 rng(5);
+        const int edits = 20000;
+        double refreshSecs = 0.0, rebuildSecs = 0.0;
+        for (int i = 0; i < edits; ++i) {
+            VoxelChunk* chunk = surface[rng() % surface.size()];
+            int x = int(rng() % CHUNK_SIZE), y = int(rng() % CHUNK_SIZE), z = int(rng() % CHUNK_SIZE);
+            chunk->setVoxel(x, y, z, Voxel{ !chunk->isVoxelSolid(x, y, z), MATERIAL_STONE });
+            VoxelChunk::Neighbours neighbours = world.neighboursOf(chunk->getChunkPos());
+
+            auto start = Clock::now();
+            chunk->refreshMesh(neighbours);
+            refreshSecs += secondsSince(start);
+            start = Clock::now();
+            chunk->buildMesh(neighbours);
+            rebuildSecs += secondsSince(start);
+        }
+        std::printf("  single-voxel edit: %.2f us refreshing stale sections, %.2f us rebuilding the chunk\n",
+                    refreshSecs / edits * 1e6, rebuildSecs / edits * 1e6);
+    }
+
+    // Naive faces against greedy rectangles over the same terrain, culled against neighbours
+    void benchMeshModes(int width, int depth, int maxHeight) {
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+        std::vector<VoxelChunk*> list = chunksOf(world);
+
+        std::printf("Mesh modes %dx%d, maxHeight %d, %zu chunks:\n", width, depth, maxHeight, list.size());
+        for (MeshMode mode : { MeshMode::Faces, MeshMode::Greedy }) {
+            // Timed on the second pass, once the section buffers have grown
+            size_t vertices = 0;
+            double secs = 0.0;
+            for (int pass = 0; pass < 2; ++pass) {
+                vertices = 0;
+                auto start = Clock::now();
+                for (VoxelChunk* chunk : list) {
+                    chunk->buildMesh(world.neighboursOf(chunk->getChunkPos()), mode);
+                    vertices += chunk->meshVertexCount();
+                }
+                secs = secondsSince(start);
+            }
+            std::printf("  %-6s %8zu triangles, %7.1f MB of VBO, %6.1f us avg per chunk\n",
+                        mode == MeshMode::Greedy ? "greedy" : "faces", vertices / 2,
+                        vertices * sizeof(ChunkVertex) / 1048576.0, secs / list.size() * 1e6);
+        }
+
+        // Projectile-style single-voxel edits, remeshing the stale sections greedily
+        std::mt19937 rng(5);
+        const int edits = 20000;
+        double refreshSecs = 0.0;
+        for (int i = 0; i < edits; ++i) {
+            VoxelChunk* chunk = list[rng() % list.size()];
+            int x = int(rng() % CHUNK_SIZE), y = int(rng() % CHUNK_SIZE), z = int(rng() % CHUNK_SIZE);
+            chunk->setVoxel(x, y, z, Voxel{ !chunk->isVoxelSolid(x, y, z), MATERIAL_STONE });
+            VoxelChunk::Neighbours neighbours = world.neighboursOf(chunk->getChunkPos());
+
+            auto start = Clock::now();
+            chunk->refreshMesh(neighbours, MeshMode::Greedy);
+            refreshSecs += secondsSince(start);
+        }
+        std::printf("  greedy single-voxel edit: %.2f us refreshing stale sections\n", refreshSecs / edits * 1e6);
+    }
+
+    // The world's perlin terrain generated at a given chunk edge, to compare sizes
+    template <int Size>
+    struct SizedTerrain {
+        using Chunk = BasicVoxelChunk<Size>;
+        MortonHashMap<std::unique_ptr<Chunk>> chunks;
+        int maxHeight;
+
+        SizedTerrain(int width, int depth, int maxHeight) : maxHeight(maxHeight) {
+            for (int cx = -width / 2 / Size; cx < width / 2 / Size; ++cx)
+                for (int cz = -depth / 2 / Size; cz < depth / 2 / Size; ++cz)
+                    for (int cy = 0; cy * Size <= maxHeight; ++cy)
+                        generateChunk(glm::ivec3(cx, cy, cz));
+        }
+
+        void generateChunk(const glm::ivec3& chunkPos) {
+            glm::ivec3 origin = chunkPos * Size;
+            auto chunk = std::make_unique<Chunk>(chunkPos);
+            chunk->compactColumns();
+            bool any = false;
+            for (int x = 0; x < Size; ++x) {
+                for (int z = 0; z < Size; ++z) {
+                    float noise = stb_perlin_noise3((origin.x + x) * 0.1f, 0.0f, (origin.z + z) * 0.1f, 0, 0, 0);
+                    int height = static_cast<int>((noise + 1.0f) / 2.0f * maxHeight);
+                    if (height < origin.y) continue;
+
+                    // Same bands as VoxelWorld: stone, three of dirt, a grass cap
+                    int stone = std::max(height - 3, 0);
+                    int bounds[4] = { 0, stone, height, height + 1 };
+                    MaterialId bands[3] = { MATERIAL_STONE, MATERIAL_DIRT, MATERIAL_GRASS };
+                    VoxelRun runs[3];
+                    int count = 0;
+                    for (int i = 0; i < 3; ++i) {
+                        int from = std::max(bounds[i], origin.y), to = std::min(bounds[i + 1], origin.y + Size);
+                        if (from < to) runs[count++] = { bands[i], to - from };
+                    }
+                    chunk->setColumnRuns(x, z, std::span<const VoxelRun>(runs, count));
+                    any = true;
+                }
+            }
+            if (!any) return;
+            chunk->publish();
+            *chunks.tryEmplace(chunkPos).first = std::move(chunk);
+        }
+
+        Chunk* chunkAt(const glm::ivec3& worldPos) {
+            auto* chunk = chunks.find(toChunkPos<Size>(worldPos));
+            return chunk ? chunk->get() : nullptr;
+        }
+    };
+
+    // Memory, meshing time, draw calls and single-voxel edit latency (edit plus
+    // remesh of the owning chunk) for one chunk edge
+    template <int Size>
+    void benchChunkSize(int width, int depth, int maxHeight) {
+        size_t before = g_liveBytes;
+        SizedTerrain<Size> terrain(width, depth, maxHeight);
+        size_t bytes = g_liveBytes - before;
+
+        size_t drawCalls = 0, vertices = 0;
+        auto start = Clock::now();
+        for (auto& [key, chunk] : terrain.chunks) {
+            chunk->buildMesh();
+            drawCalls += chunk->meshVertexCount() != 0;
+            vertices += chunk->meshVertexCount();
+        }
+        double meshSecs = secondsSince(start);
+
+        auto edits = randomProbes(width, depth, maxHeight, 2000);
+        size_t edited = 0;
+        start = Clock::now();
+        for (const glm::ivec3& p : edits) {
+            auto* chunk = terrain.chunkAt(p);
+            if (!chunk) continue;
+            glm::ivec3 local = toLocalPos<Size>(p);
+            chunk->setVoxel(local.x, local.y, local.z, Voxel{ !chunk->isVoxelSolid(local.x, local.y, local.z) });
+            chunk->buildMesh();
+            ++edited;
+        }
+        double editSecs = secondsSince(start);
+
+        std::printf("  %2d^3: %5zu chunks %8.2f MB  mesh all %7.1f ms  %5zu draw calls %8.2f MB mesh  edit+remesh %7.1f us\n",
+                    Size, terrain.chunks.size(), bytes / (1024.0 * 1024.0), meshSecs * 1e3, drawCalls,
+                    vertices * sizeof(ChunkVertex) / (1024.0 * 1024.0), edited ? editSecs / edited * 1e6 : 0.0);
+    }
+
+    void benchChunkSizes(int width, int depth, int maxHeight) {
+        std::printf("Chunk edge %dx%d, maxHeight %d (world uses %d)\n", width, depth, maxHeight, CHUNK_SIZE);
+        benchChunkSize<16>(width, depth, maxHeight);
+        benchChunkSize<32>(width, depth, maxHeight);
+        benchChunkSize<64>(width, depth, maxHeight);
+    }
+
+    template <typename World>
+    void benchQueryAndEdit(const char* name, World& world, size_t bytes,
+                           const std::vector<glm::ivec3>& probes, const std::vector<glm::ivec3>& edits) {
+        size_t hits = 0;
+        auto start = Clock::now();
+        for (const auto& p : probes) {
+            auto v = world.getVoxel(p);
+            if (v && v->active) ++hits;
+        }
+        double querySecs = secondsSince(start);
+
+        start = Clock::now();
+        for (const auto& p : edits) world.deactivateVoxel(p);
+        double editSecs = secondsSince(start);
+
+        std::printf("  %-14s %9.2f MB  query %6.1f ns  edit %6.1f ns  (%zu hits)\n",
+                    name, bytes / (1024.0 * 1024.0),
+                    querySecs / probes.size() * 1e9, editSecs / edits.size() * 1e9, hits);
+    }
+
+    void benchOctree(int size, int maxHeight) {
+        std::printf("Octree vs chunk map, %d^3 world, maxHeight %d\n", size, maxHeight);
+        auto probes = randomProbes(size, size, maxHeight, 2'000'000);
+        auto edits = randomProbes(size, size, maxHeight, 200'000);
+
+        size_t before = g_liveBytes;
+        VoxelWorld world;
+        world.generateTerrain(size, size, maxHeight);
+        size_t worldBytes = g_liveBytes - before;
+
+        // Levels covering the world cube, filled from the generated chunks
+        int levels = 0;
+        while ((1 << levels) < size) ++levels;
+        SparseVoxelOctree octree(levels, glm::ivec3(-size / 2, 0, -size / 2));
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            glm::ivec3 base = chunk->getChunkPos() * CHUNK_SIZE;
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int y = 0; y < CHUNK_SIZE; ++y)
+                    for (int z = 0; z < CHUNK_SIZE; ++z) {
+                        Voxel v = chunk->getVoxel(x, y, z);
+                        if (v.active) octree.setVoxel(base + glm::ivec3(x, y, z), v);
+                    }
+        }
+
+        benchQueryAndEdit("chunk map", world, worldBytes, probes, edits);
+        benchQueryAndEdit("octree", octree, octree.memoryUsage(), probes, edits);
+        std::printf("  octree nodes: %zu\n", octree.nodeCount());
+
+        // Freeze the (edited) octree into a shared-subtree DAG
+        auto start = Clock::now();
+        SparseVoxelDag dag(octree);
+        double buildSecs = secondsSince(start);
+
+        size_t hits = 0;
+        start = Clock::now();
+        for (const auto& p : probes) {
+            auto v = dag.getVoxel(p);
+            if (v && v->active) ++hits;
+        }
+        double querySecs = secondsSince(start);
+
+        double denseBytes = double(size) * size * maxHeight * sizeof(MaterialId);
+        std::printf("  %-14s %9.2f MB  query %6.1f ns  (%zu hits), %zu nodes, built in %.2f s, %.4f%% of dense\n",
+                    "dag", dag.memoryUsage() / (1024.0 * 1024.0), querySecs / probes.size() * 1e9, hits,
+                    dag.nodeCount(), buildSecs, dag.memoryUsage() / denseBytes * 100.0);
+
+        // The same straight from the world, one ChunkPool region at a time
+        std::vector<glm::ivec3> regions;
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            glm::ivec3 regionPos = ChunkPool::regionOf(chunk->getChunkPos());
+            if (std::find(regions.begin(), regions.end(), regionPos) == regions.end()) regions.push_back(regionPos);
+        }
+        before = g_liveBytes;
+        start = Clock::now();
+        std::size_t frozen = 0;
+        for (const glm::ivec3& regionPos : regions) frozen += world.freezeRegion(regionPos);
+        world.chunks.reclaim();
+        world.chunkPool.shrink();
+        double freezeSecs = secondsSince(start);
+        size_t frozenBytes = worldBytes + g_liveBytes - before;
+        start = Clock::now();
+        for (const glm::ivec3& regionPos : regions) world.thawRegion(regionPos);
+        double thawSecs = secondsSince(start);
+        std::printf("  %-14s %9.2f MB  %zu regions, %zu chunks frozen in %.2f s, thawed in %.2f s\n",
+                    "region dags", frozenBytes / (1024.0 * 1024.0), regions.size(), frozen, freezeSecs, thawSecs);
+    }
+
+    void benchHashTables(int extent, int height) {
+        std::printf("Hash tables, %dx%dx%d keys\n", extent, height, extent);
+        std::vector<glm::ivec3> keys;
+        for (int x = -extent / 2; x < extent / 2; ++x)
+            for (int y = 0; y < height; ++y)
+                for (int z = -extent / 2; z < extent / 2; ++z)
+                    keys.emplace_back(x, y, z);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+        auto probes = randomProbes(extent, extent, height, 1'000'000);
+
+        static const glm::ivec3 offsets[6] = {
+            {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+        };
+
+        // Baseline: std::unordered_map with the original VoxelHash
+        {
+            std::unordered_map<VoxelPos, int, VoxelHash> map;
+            auto start = Clock::now();
+            for (size_t i = 0; i < keys.size(); ++i) map[{keys[i].x, keys[i].y, keys[i].z}] = int(i);
+            double insertSecs = secondsSince(start);
+
+            size_t found = 0;
+            start = Clock::now();
+            for (const auto& p : probes) found += map.count({p.x, p.y, p.z});
+            double findSecs = secondsSince(start);
+
+            size_t neighbours = 0;
+            start = Clock::now();
+            for (const auto& p : probes)
+                for (const auto& o : offsets) neighbours += map.count({p.x + o.x, p.y + o.y, p.z + o.z});
+            double sixSecs = secondsSince(start);
+
+            std::printf("  %-14s insert %6.1f ns  find %6.1f ns  6-neighbour %6.1f ns  (%zu/%zu)\n", "unordered_map",
+                        insertSecs / keys.size() * 1e9, findSecs / probes.size() * 1e9,
+                        sixSecs / probes.size() * 1e9, found, neighbours);
+        }
+
+        {
+            MortonHashMap<int> map;
+            auto start = Clock::now();
+            for (size_t i = 0; i < keys.size(); ++i) map[keys[i]] = int(i);
+            double insertSecs = secondsSince(start);
+
+            size_t found = 0;
+            start = Clock::now();
+            for (const auto& p : probes) found += map.find(p) != nullptr;
+            double findSecs = secondsSince(start);
+
+            // All six neighbours go through one batched, prefetched lookup
+            size_t neighbours = 0;
+            start = Clock::now();
+            for (const auto& p : probes) {
+                glm::ivec3 batch[6];
+                int* results[6];
+                for (int i = 0; i < 6; ++i) batch[i] = p + offsets[i];
+                map.findBatch(batch, 6, results);
+                for (int* r : results) neighbours += r != nullptr;
+            }
+            double sixSecs = secondsSince(start);
+
+            std::printf("  %-14s insert %6.1f ns  find %6.1f ns  6-neighbour %6.1f ns  (%zu/%zu)\n", "morton flat",
+                        insertSecs / keys.size() * 1e9, findSecs / probes.size() * 1e9,
+                        sixSecs / probes.size() * 1e9, found, neighbours);
+        }
+    }
+
+    // A light pass over every voxel: light as its own channel versus light inside
+    // a fat per-voxel struct, which drags the other fields through the cache
+    void benchChannels(int width, int depth, int maxHeight) {
+        struct FatVoxel {
+            bool active;
+            MaterialId material;
+            LightLevel light;
+            DamageLevel damage;
+        };
+
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+        std::vector<VoxelChunk*> chunks = chunksOf(world);
+
+        size_t before = g_liveBytes;
+        std::vector<std::vector<FatVoxel>> fat(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            fat[i].resize(CHUNK_VOLUME);
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int y = 0; y < CHUNK_SIZE; ++y)
+                    for (int z = 0; z < CHUNK_SIZE; ++z) {
+                        Voxel voxel = chunks[i]->getVoxel(x, y, z);
+                        LightLevel light = LightLevel((chunks[i]->getChunkPos().y * CHUNK_SIZE + y) & 15);
+                        chunks[i]->setLight(x, y, z, light);
+                        fat[i][voxelIndex(x, y, z)] = { voxel.active, voxel.material, light, 0 };
+                    }
+            chunks[i]->publish();
+        }
+        size_t fatBytes = chunks.size() * CHUNK_VOLUME * sizeof(FatVoxel);
+        size_t channelBytes = g_liveBytes - before - fatBytes;
+
+        const int passes = 20;
+        size_t soaSum = 0, aosSum = 0;
+        auto start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass)
+            for (VoxelChunk* chunk : chunks)
+                for (LightLevel light : chunk->voxels().getLightChannel().data()) soaSum += light;
+        double soaSecs = secondsSince(start);
+
+        start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass)
+            for (const auto& voxels : fat)
+                for (const FatVoxel& voxel : voxels) aosSum += voxel.light;
+        double aosSecs = secondsSince(start);
+
+        double voxels = double(chunks.size()) * CHUNK_VOLUME * passes;
+        std::printf("Light pass %dx%d, maxHeight %d, %zu chunks (sums %zu/%zu)\n",
+                    width, depth, maxHeight, chunks.size(), soaSum, aosSum);
+        std::printf("  channel        %8.2f MB  %6.2f ns/voxel\n", channelBytes / (1024.0 * 1024.0), soaSecs / voxels * 1e9);
+        std::printf("  struct (%zu B)  %8.2f MB  %6.2f ns/voxel\n", sizeof(FatVoxel), fatBytes / (1024.0 * 1024.0), aosSecs / voxels * 1e9);
+    }
+
+    // Picking-style rays from well above the terrain: quarter-voxel marching through
+    // getVoxel against VoxelWorld::raycast, which skips empty chunks/blocks/bricks
+    void benchRaycast(int width, int depth, int maxHeight) {
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        const int rayCount = 20'000;
+        const float reach = 256.0f;
+        std::vector<std::pair<glm::vec3, glm::vec3>> rays(rayCount);
+        for (auto& [origin, dir] : rays) {
+            origin = glm::vec3(unit(rng) * width * 0.4f, float(maxHeight + 64), unit(rng) * depth * 0.4f);
+            dir = glm::normalize(glm::vec3(unit(rng), -0.2f - std::fabs(unit(rng)), unit(rng)));
+        }
+
+        size_t marchHits = 0;
+        auto start = Clock::now();
+        for (const auto& [origin, dir] : rays) {
+            for (float t = 0.0f; t < reach; t += 0.25f) {
+                glm::vec3 p = origin + dir * t;
+                auto v = world.getVoxel(glm::ivec3(int(std::floor(p.x + 0.5f)), int(std::floor(p.y + 0.5f)),
+                                                   int(std::floor(p.z + 0.5f))));
+                if (v && v->active) { ++marchHits; break; }
+            }
+        }
+        double marchSecs = secondsSince(start);
+
+        size_t castHits = 0;
+        start = Clock::now();
+        for (const auto& [origin, dir] : rays)
+            castHits += world.raycast(origin, dir, reach).has_value();
+        double castSecs = secondsSince(start);
+
+        std::printf("Raycast %dx%d, maxHeight %d, %d rays of %.0f voxels\n", width, depth, maxHeight, rayCount, reach);
+        std::printf("  quarter-voxel march %8.2f us/ray (%zu hits)\n", marchSecs / rayCount * 1e6, marchHits);
+        std::printf("  hierarchical DDA    %8.2f us/ray (%zu hits)\n", castSecs / rayCount * 1e6, castHits);
+    }
+
+    // Compile-time layout: rebuild with -DMAGMA_MORTON_CHUNK_LAYOUT=ON and compare,
+    // e.g. under perf stat -e cache-misses ./magma-bench layout
+    void benchChunkLayout(int width, int depth, int maxHeight) {
+#ifdef MAGMA_MORTON_CHUNK_LAYOUT
+        const char* layout = "morton";
+#else
+        const char* layout = "row-major";
+#endif
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+        std::printf("Chunk layout (%s), %dx%d, maxHeight %d\n", layout, width, depth, maxHeight);
+
+        // Mesher-style walk: each voxel against its +x/+y/+z neighbours through stepIndex
+        size_t boundaries = 0;
+        auto start = Clock::now();
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            if (chunk->getStorage() != ChunkStorage::Dense) continue;
+            const PaletteStorage& materials = chunk->getMaterials();
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int y = 0; y < CHUNK_SIZE; ++y)
+                    for (int z = 0; z < CHUNK_SIZE; ++z) {
+                        int index = voxelIndex(x, y, z);
+                        MaterialId material = materials.get(index);
+                        if (x + 1 < CHUNK_SIZE) boundaries += materials.get(stepIndex(index, FaceDirection::Right)) != material;
+                        if (y + 1 < CHUNK_SIZE) boundaries += materials.get(stepIndex(index, FaceDirection::Top)) != material;
+                        if (z + 1 < CHUNK_SIZE) boundaries += materials.get(stepIndex(index, FaceDirection::Front)) != material;
+                    }
+        }
+        double walkSecs = secondsSince(start);
+
+        // Rays marched in quarter-voxel steps from above the terrain, angled downwards
+        std::mt19937 rng(99);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        const int rayCount = 200'000;
+        size_t rayHits = 0, raySteps = 0;
+        start = Clock::now();
+        for (int i = 0; i < rayCount; ++i) {
+            glm::vec3 origin(unit(rng) * width * 0.4f, float(maxHeight), unit(rng) * depth * 0.4f);
+            glm::vec3 dir = glm::normalize(glm::vec3(unit(rng), -1.0f, unit(rng)));
+            for (float t = 0.0f; t < 64.0f; t += 0.25f, ++raySteps) {
+                glm::vec3 p = origin + dir * t;
+                auto v = world.getVoxel(glm::ivec3(int(std::floor(p.x + 0.5f)), int(std::floor(p.y + 0.5f)),
+                                                   int(std::floor(p.z + 0.5f))));
+                if (v && v->active) { ++rayHits; break; }
+            }
+        }
+        double raySecs = secondsSince(start);
+
+        // 8^3 region copies between random dense chunks
+        std::vector<VoxelChunk*> dense;
+        for (VoxelChunk* chunk : chunksOf(world))
+            if (chunk->getStorage() == ChunkStorage::Dense) dense.push_back(chunk);
+        const int copyCount = 20'000;
+        start = Clock::now();
+        for (int i = 0; i < copyCount && dense.size() > 1; ++i) {
+            const VoxelChunk* from = dense[rng() % dense.size()];
+            VoxelChunk* to = dense[rng() % dense.size()];
+            int ox = int(rng() % 9), oy = int(rng() % 9), oz = int(rng() % 9);
+            for (int x = 0; x < 8; ++x)
+                for (int y = 0; y < 8; ++y)
+                    for (int z = 0; z < 8; ++z)
+                        to->setVoxel(ox + x, oy + y, oz + z, from->getVoxel(x, y, z));
+        }
+        double copySecs = secondsSince(start);
+
+        std::printf("  neighbour walk %6.2f ms (%zu boundaries)  ray step %5.1f ns (%zu hits)  8^3 copy %6.2f us\n",
+                    walkSecs * 1e3, boundaries, raySecs / raySteps * 1e9, rayHits, copySecs / copyCount * 1e6);
+    }
+
+    // Streaming churn: a window of chunks slides along x, unloading the trailing
+    // slice and generating + meshing the leading one. Headless, so the GL handle
+    // reuse the pool also provides does not show up here.
+    template <typename Acquire>
+    double churnChunks(int radius, int steps, Acquire acquire) {
+        using Owned = decltype(acquire(glm::ivec3(0)));
+        MortonHashMap<Owned> window;
+        VoxelRun column[2] = { { MATERIAL_STONE, 6 }, { MATERIAL_GRASS, 1 } };
+
+        auto load = [&](const glm::ivec3& chunkPos) {
+            Owned chunk = acquire(chunkPos);
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    column[0].length = 4 + (x * 7 + z * 3 + chunkPos.x) % 8;
+                    chunk->setColumnRuns(x, z, column);
+                }
+            chunk->buildMesh();
+            window[chunkPos] = std::move(chunk);
+        };
+
+        auto start = Clock::now();
+        for (int step = 0; step < steps; ++step) {
+            for (int z = -radius; z <= radius; ++z) {
+                if (step == 0) {
+                    for (int x = -radius; x <= radius; ++x) load(glm::ivec3(x, 0, z));
+                    continue;
+                }
+                window.erase(glm::ivec3(step - radius - 1, 0, z));
+                load(glm::ivec3(step + radius, 0, z));
+            }
+        }
+        return secondsSince(start);
+    }
+
+    void benchChunkPool(int radius, int steps) {
+        int sliceSize = 2 * radius + 1;
+        std::printf("Chunk churn, %dx%d window, %d steps (%d loads per step)\n", sliceSize, sliceSize, steps, sliceSize);
+
+        size_t allocationsBefore = g_allocations;
+        double heapSecs = churnChunks(radius, steps, [](const glm::ivec3& chunkPos) {
+            return std::make_unique<VoxelChunk>(chunkPos);
+        });
+        size_t heapAllocations = g_allocations - allocationsBefore;
+
+        ChunkPool pool;
+        allocationsBefore = g_allocations;
+        double poolSecs = churnChunks(radius, steps, [&](const glm::ivec3& chunkPos) {
+            return pool.acquire(chunkPos);
+        });
+        size_t poolAllocations = g_allocations - allocationsBefore;
+
+        const ChunkPool::Stats& stats = pool.getStats();
+        std::printf("  new/delete %7.1f ms, %zu allocations\n", heapSecs * 1e3, heapAllocations);
+        std::printf("  pool       %7.1f ms, %zu allocations\n", poolSecs * 1e3, poolAllocations);
+        std::printf("  pool: %zu regions + %zu spare, capacity %zu, in use %zu, high water %zu, %zu regions recycled, "
+                    "%zu of %zu acquires overflowed, %.1f KB\n",
+                    stats.regions, stats.spareRegions, stats.capacity, stats.inUse, stats.highWater, stats.recycled,
+                    stats.overflow, stats.acquires, pool.memoryUsage() / 1024.0);
+    }
+
+    // A per-frame style pass over every chunk header (as draw's visibility pass
+    // and residency trim do), in directory hash order versus pool region order
+    void benchRegionWalk(int width, int depth, int maxHeight, int passes) {
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+
+        size_t solid = 0;
+        auto visit = [&](VoxelChunk& chunk) {
+            chunk.lastAccess += chunk.getChunkPos().y;
+            solid += chunk.voxels().getSummary().anySolid();
+        };
+
+        auto start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass) world.chunks.forEach(visit);
+        double directorySecs = secondsSince(start);
+
+        start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass) world.chunkPool.forEachChunk(visit);
+        double regionSecs = secondsSince(start);
+
+        ChunkPool::Stats stats = world.chunkPool.getStats();
+        double visits = double(world.chunks.size()) * passes;
+        std::printf("Chunk walk %dx%d, maxHeight %d: %zu chunks in %zu regions (%zu solid visits)\n",
+                    width, depth, maxHeight, world.chunks.size(), stats.regions, solid);
+        std::printf("  directory order %6.1f ns/chunk, region order %6.1f ns/chunk\n",
+                    directorySecs / visits * 1e9, regionSecs / visits * 1e9);
+    }
+
+    // Worker threads read random voxels through chunk snapshots while the main
+    // thread keeps deactivating voxels, as projectile hits do in main.cpp
+    void benchSnapshots(int width, int depth, int maxHeight, int readerCount) {
+        VoxelWorld world;
+        world.generateTerrain(width, depth, maxHeight);
+        std::vector<VoxelChunk*> chunkList = chunksOf(world);
+
+        std::atomic<bool> stop{ false };
+        std::vector<size_t> reads(readerCount, 0), solidReads(readerCount, 0);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; ++r) {
+            readers.emplace_back([&, r] {
+                std::mt19937 rng(r + 1);
+                size_t count = 0, solid = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    std::shared_ptr<const ChunkVoxels> snapshot = chunkList[rng() % chunkList.size()]->snapshot();
+                    for (int i = 0; i < 256; ++i, ++count)
+                        solid += snapshot->isVoxelSolid(int(rng() % CHUNK_SIZE), int(rng() % CHUNK_SIZE), int(rng() % CHUNK_SIZE));
+                }
+                reads[r] = count;
+                solidReads[r] = solid;
+            });
+        }
+
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> px(-width / 2, width / 2 - 1), pz(-depth / 2, depth / 2 - 1), py(0, maxHeight);
+        size_t edits = 0;
+        auto start = Clock::now();
+        while (secondsSince(start) < 1.0) {
+            for (int i = 0; i < 64; ++i, ++edits)
+                world.deactivateVoxel(glm::ivec3(px(rng), py(rng), pz(rng)));
+        }
+        double secs = secondsSince(start);
+        stop = true;
+        for (std::thread& reader : readers) reader.join();
+
+        size_t totalReads = 0, totalSolid = 0;
+        for (int r = 0; r < readerCount; ++r) totalReads += reads[r], totalSolid += solidReads[r];
+        std::printf("Snapshots, %d reader threads: %.1f M voxel reads/s (%.0f%% solid), writer %.0f k edits/s (publish per edit)\n",
+                    readerCount, totalReads / secs / 1e6, totalReads ? 100.0 * totalSolid / totalReads : 0.0, edits / secs / 1e3);
+    }
+
+    // A player walks across the terrain touching the chunks around it each frame
+    // and shooting the occasional voxel, with the world held to a byte budget
+    void benchResidency(int size, int maxHeight, double budgetFraction) {
+        VoxelWorld world;
+        world.generateTerrain(size, size, maxHeight);
+        std::filesystem::path storeDir = std::filesystem::temp_directory_path() / "magma-bench-chunks";
+        std::filesystem::remove_all(storeDir);
+        world.chunkStore = std::make_unique<ChunkStore>(storeDir);
+
+        size_t fullBytes = 0;
+        for (VoxelChunk* chunk : chunksOf(world)) fullBytes += chunk->memoryUsage();
+        world.residency.budgetBytes = size_t(fullBytes * budgetFraction);
+
+        std::mt19937 rng(3);
+        const int frames = 2000, radius = 3;
+        float playerX = -size / 2 + 8.0f, playerZ = -size / 2 + 8.0f;
+        auto start = Clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            // Diagonal sweep, wrapping at the edges
+            playerX += 0.9f;
+            playerZ += 0.4f;
+            if (playerX > size / 2 - 8) playerX -= size - 16;
+            if (playerZ > size / 2 - 8) playerZ -= size - 16;
+            glm::ivec3 centre = toChunkPos(glm::ivec3(int(playerX), 0, int(playerZ)));
+
+            for (int dx = -radius; dx <= radius; ++dx)
+                for (int dz = -radius; dz <= radius; ++dz)
+                    for (int cy = 0; cy * CHUNK_SIZE <= maxHeight; ++cy)
+                        world.loadChunk(glm::ivec3(centre.x + dx, cy, centre.z + dz));
+
+            if (frame % 4 == 0)
+                world.deactivateVoxel(glm::ivec3(int(playerX) + int(rng() % 9) - 4, int(rng() % maxHeight),
+                                                 int(playerZ) + int(rng() % 9) - 4));
+            world.trimToBudget();
+        }
+        double secs = secondsSince(start);
+
+        const ChunkResidency::Stats& stats = world.residency.getStats();
+        std::printf("Residency %dx%d, budget %.0f%% of %.1f MB: %.1f us/frame, hit rate %.4f, %zu evictions (%.0f/s), "
+                    "%zu flushes, %.1f MB resident\n",
+                    size, size, budgetFraction * 100, fullBytes / 1048576.0, secs / frames * 1e6, stats.hitRate(),
+                    stats.evictions, stats.evictions / secs, stats.flushes, stats.bytesResident / 1048576.0);
+        std::filesystem::remove_all(storeDir);
+    }
+
+    // Shots knock out surface voxels, then every chunk is evicted and the shot
+    // voxels read back. Dense: edited chunks are saved whole; overlay: only the
+    // EditOverlay is kept and saved, chunks are regenerated
+    void benchEditOverlay(int size, int maxHeight, int shots, bool overlay) {
+        VoxelWorld world;
+        world.overlayStorage = overlay;
+        std::filesystem::path storeDir = std::filesystem::temp_directory_path() / "magma-bench-overlay";
+        std::filesystem::remove_all(storeDir);
+        world.chunkStore = std::make_unique<ChunkStore>(storeDir);
+        world.generateTerrain(size, size, maxHeight);
+
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<int> coord(-size / 2, size / 2 - 1);
+        std::vector<glm::ivec3> shot;
+        for (int i = 0; i < shots; ++i) {
+            glm::vec3 from(float(coord(rng)), float(maxHeight + 4), float(coord(rng)));
+            if (auto hit = world.raycast(from, glm::vec3(0.0f, -1.0f, 0.0f), float(maxHeight + 8))) {
+                world.deactivateVoxel(hit->voxel);
+                shot.push_back(hit->voxel);
+            }
+        }
+
+        // What keeping the edits costs in memory: the edited chunks themselves, or the overlay
+        size_t editedChunks = world.edits.chunkCount(), editBytes = world.edits.memoryUsage();
+        for (VoxelChunk* chunk : chunksOf(world)) {
+            if (!chunk->isUnsaved()) continue;
+            ++editedChunks;
+            editBytes += chunk->memoryUsage();
+        }
+
+        auto start = Clock::now();
+        world.residency.budgetBytes = 1;
+        world.trimToBudget();
+        world.trimToBudget();
+        if (overlay) world.saveEdits();
+        double saveSecs = secondsSince(start);
+        size_t resident = world.chunks.size();
+
+        size_t diskBytes = 0, files = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(storeDir)) {
+            diskBytes += entry.file_size();
+            ++files;
+        }
+
+        start = Clock::now();
+        size_t wrong = 0;
+        for (const glm::ivec3& voxel : shot) {
+            std::optional<Voxel> v = world.getVoxel(voxel);
+            wrong += v && v->active;
+        }
+        double restoreSecs = secondsSince(start);
+
+        std::printf("  %-7s %4zu shots: %4zu chunks edited, %7.1f KB to hold the edits in memory, "
+                    "%8.1f KB in %3zu files, evict+save %6.1f ms, restore %6.1f ms, %zu wrong\n",
+                    overlay ? "overlay" : "dense", shot.size(), editedChunks, editBytes / 1024.0,
+                    diskBytes / 1024.0, files, saveSecs * 1e3, restoreSecs * 1e3, wrong);
+        if (resident != 0) std::printf("    (%zu chunks could not be evicted)\n", resident);
+        std::filesystem::remove_all(storeDir);
+    }
+
+    // The pre-sharding layout: one map behind one reader/writer lock
+    struct GlobalLockDirectory {
+        mutable std::shared_mutex mutex;
+        MortonHashMap<ChunkPool::Handle> chunks;
+        std::vector<ChunkPool::Handle> retired;
+
+        VoxelChunk* get(const glm::ivec3& chunkPos) const {
+            std::shared_lock lock(mutex);
+            const ChunkPool::Handle* handle = chunks.find(chunkPos);
+            return handle ? handle->get() : nullptr;
+        }
+
+        template <typename Create>
+        VoxelChunk& getOrCreate(const glm::ivec3& chunkPos, Create&& create) {
+            if (VoxelChunk* chunk = get(chunkPos)) return *chunk;
+            std::unique_lock lock(mutex);
+            auto [handle, inserted] = chunks.tryEmplace(chunkPos);
+            if (inserted) *handle = create();
+            return **handle;
+        }
+
+        bool erase(const glm::ivec3& chunkPos) {
+            std::unique_lock lock(mutex);
+            ChunkPool::Handle* handle = chunks.find(chunkPos);
+            if (!handle) return false;
+            retired.push_back(std::move(*handle));
+            return chunks.erase(chunkPos);
+        }
+    };
+
+    // 80% get, 15% getOrCreate, 5% erase over a 64x4x64 chunk region
+    template <typename Directory>
+    double mixedDirectoryOps(Directory& directory, ChunkPool& pool, int threadCount, int totalOps) {
+        std::vector<std::thread> threads;
+        std::atomic<size_t> found{ 0 };
+        auto start = Clock::now();
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(t + 11);
+                size_t hits = 0;
+                for (int i = 0; i < totalOps / threadCount; ++i) {
+                    std::uint32_t r = rng();
+                    glm::ivec3 chunkPos(int(r & 63) - 32, int(r >> 6 & 3), int(r >> 8 & 63) - 32);
+                    int op = int((r >> 16) % 100);
+                    if (op < 80) hits += directory.get(chunkPos) != nullptr;
+                    else if (op < 95) hits += directory.getOrCreate(chunkPos, [&] { return pool.acquire(chunkPos); })
+                                                  .getChunkPos() == chunkPos;
+                    else directory.erase(chunkPos);
+                }
+                found += hits;
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        return secondsSince(start);
+    }
+
+    void benchDirectoryScaling(int totalOps) {
+        std::printf("Chunk directory, mixed 80/15/5 get/create/erase, %d ops, %u hardware threads\n",
+                    totalOps, std::thread::hardware_concurrency());
+        for (int threadCount : { 1, 2, 4, 8, 16, 32 }) {
+            ChunkPool pool;
+            double globalSecs, shardedSecs;
+            {
+                GlobalLockDirectory directory;
+                globalSecs = mixedDirectoryOps(directory, pool, threadCount, totalOps);
+            }
+            {
+                ChunkDirectory directory;
+                shardedSecs = mixedDirectoryOps(directory, pool, threadCount, totalOps);
+            }
+            std::printf("  %2d threads: one lock %6.2f Mops/s, %zu shards %6.2f Mops/s\n", threadCount,
+                        totalOps / globalSecs / 1e6, ChunkDirectory::SHARD_COUNT, totalOps / shardedSecs / 1e6);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    // ./magma-bench [section...] runs only the named sections, no arguments runs everything
+    auto wants = [&](const char* section) {
+        if (argc < 2) return true;
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], section) == 0) return true;
+        return false;
+    };
+
+    if (wants("world")) {
+        benchWorldStorage(64, 64, 32);
+        benchWorldStorage(128, 128, 32);
+    }
+    if (wants("bytes")) {
+        benchChunkBytes(256, 256, 48, false);
+        benchChunkBytes(256, 256, 48, true);
+    }
+    if (wants("mesh")) benchMeshing(256, 256, 48);
+    if (wants("greedy")) benchMeshModes(256, 256, 48);
+    if (wants("sizes")) benchChunkSizes(512, 512, 48);
+    if (wants("octree")) benchOctree(1024, 64);
+    if (wants("hash")) benchHashTables(128, 16);
+    if (wants("layout")) benchChunkLayout(256, 256, 48);
+    if (wants("raycast")) benchRaycast(256, 256, 48);
+    if (wants("channels")) benchChannels(256, 256, 48);
+    if (wants("pool")) benchChunkPool(8, 400);
+    if (wants("regions")) benchRegionWalk(1024, 1024, 48, 50);
+    if (wants("residency")) {
+        benchResidency(512, 48, 1.0);
+        benchResidency(512, 48, 0.25);
+    }
+    if (wants("overlay")) {
+        std::printf("Edit overlay, 512x512 terrain, maxHeight 48, all chunks evicted after shooting\n");
+        for (int shots : { 200, 2000 }) {
+            benchEditOverlay(512, 48, shots, false);
+            benchEditOverlay(512, 48, shots, true);
+        }
+    }
+    if (wants("shards")) benchDirectoryScaling(4'000'000);
+    if (wants("cow")) {
+        benchSnapshots(256, 256, 48, 0);
+        benchSnapshots(256, 256, 48, 3);
+    }
+    return 0;
+}
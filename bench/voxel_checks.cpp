@@ -0,0 +1,590 @@
+// voxel_checks.cpp
+// Headless consistency checks. Build with -DMAGMA_BUILD_BENCH=ON and run ./magma-checks
+// (or ctest). Each section compares a storage structure against a plain reference
+// under random operations; any mismatch is printed and the run exits non-zero.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "palette_storage.h"
+#include "column_runs.h"
+#include "morton_hash_map.h"
+#include "voxel_world.h"
+
+// Counts the failure and prints the first few
+#define CHECK(condition, ...)                                                    \
+    do {                                                                          \
+        if (!(condition) && ++g_failures <= 20) {                                 \
+            std::printf("  FAILED %s:%d: %s: ", __FILE__, __LINE__, #condition);  \
+            std::printf(__VA_ARGS__);                                             \
+            std::printf("\n");                                                    \
+        }                                                                         \
+    } while (0)
+
+namespace {
+    int g_failures = 0;
+
+    // Random sets against a plain array. Each phase draws from a palette sized
+    // for one index width, walking 0 -> 16 bits and back down, so every widen and
+    // every narrowing repack runs with live data in the storage.
+    void checkPaletteStorage(std::uint32_t seed) {
+        constexpr std::size_t SIZE = 4096;
+        std::mt19937 rng(seed);
+        PaletteStorage storage(SIZE, 7);
+        std::vector<MaterialId> reference(SIZE, 7);
+
+        auto verify = [&](const char* phase) {
+            for (std::size_t i = 0; i < SIZE; ++i) {
+                if (storage.get(i) == reference[i]) continue;
+                CHECK(false, "%s: entry %zu is %u, expected %u", phase, i, unsigned(storage.get(i)),
+                      unsigned(reference[i]));
+                return;
+            }
+            // Bulk matches over windows of up to one word's worth of entries, word aligned or not
+            std::uniform_int_distribution<std::size_t> start(0, SIZE - 64);
+            std::uniform_int_distribution<int> length(1, 64);
+            for (int i = 0; i < 200; ++i) {
+                std::size_t first = start(rng);
+                int count = length(rng);
+                std::uint32_t slot = storage.slotAt(first + std::size_t(rng() % unsigned(count)));
+                std::uint64_t expected = 0;
+                for (int j = 0; j < count; ++j)
+                    if (reference[first + std::size_t(j)] == storage.slotMaterial(slot))
+                        expected |= std::uint64_t(1) << j;
+                if (storage.slotMask(first, count, slot) == expected) continue;
+                CHECK(false, "%s: slot %u over %d entries from %zu matches %016llx, expected %016llx", phase,
+                      unsigned(slot), count, first, (unsigned long long)storage.slotMask(first, count, slot),
+                      (unsigned long long)expected);
+                return;
+            }
+        };
+
+        // Materials in use for each target width; the last phases shrink back to one
+        const std::size_t materialCounts[] = { 1, 2, 4, 16, 256, 1000, 256, 16, 4, 2, 1 };
+        const int widths[] = { 0, 1, 2, 4, 8, 16, 8, 4, 2, 1, 0 };
+        for (std::size_t phase = 0; phase < std::size(materialCounts); ++phase) {
+            std::size_t materials = materialCounts[phase];
+            MaterialId base = MaterialId(phase * 1000 + 1);
+            std::uniform_int_distribution<std::size_t> index(0, SIZE - 1);
+            std::uniform_int_distribution<std::size_t> pick(0, materials - 1);
+
+            // Enough random writes to pass through the intermediate widths, then
+            // a sweep so exactly this phase's materials remain
+            for (int i = 0; i < 20000; ++i) {
+                std::size_t at = index(rng);
+                MaterialId material = MaterialId(base + pick(rng));
+                storage.set(at, material);
+                reference[at] = material;
+            }
+            for (std::size_t at = 0; at < SIZE; ++at) {
+                MaterialId material = MaterialId(base + at % materials);
+                storage.set(at, material);
+                reference[at] = material;
+            }
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "phase %zu", phase);
+            verify(name);
+            CHECK(storage.paletteSize() == materials, "%s: palette holds %zu, expected %zu", name,
+                  storage.paletteSize(), materials);
+            CHECK(storage.bitsPerEntry() == widths[phase], "%s: %d bits per entry, expected %d", name,
+                  storage.bitsPerEntry(), widths[phase]);
+        }
+
+        storage.fill(3);
+        std::fill(reference.begin(), reference.end(), MaterialId(3));
+        verify("fill");
+        CHECK(storage.bitsPerEntry() == 0, "fill left %d bits per entry", storage.bitsPerEntry());
+    }
+
+    // Random column replacements against a plain array, cycling through far more
+    // materials than the 16 palette slots. With at most 16 materials live at once
+    // every replacement must fit; one bringing a 17th must fail and change nothing.
+    void checkColumnRuns(std::uint32_t seed) {
+        constexpr int SIZE = 16, COLUMNS = SIZE * SIZE;
+        std::mt19937 rng(seed);
+        ColumnRuns columns(COLUMNS, SIZE);
+        std::vector<MaterialId> reference(COLUMNS * SIZE, MATERIAL_AIR);
+
+        // Air takes a slot too once it sits below something solid
+        auto addMaterials = [](std::vector<MaterialId>& live, const MaterialId* column) {
+            int top = SIZE;
+            while (top > 0 && column[top - 1] == MATERIAL_AIR) --top;
+            for (int y = 0; y < top; ++y)
+                if (std::find(live.begin(), live.end(), column[y]) == live.end()) live.push_back(column[y]);
+        };
+
+        std::uniform_int_distribution<int> pickColumn(0, COLUMNS - 1), pickLength(1, SIZE), pickCount(0, 4);
+        std::vector<VoxelRun> runs;
+        std::vector<VoxelRun> unpacked;
+        for (int step = 0; step < 20000; ++step) {
+            // Materials drift upwards, so old ones keep dropping out of use
+            MaterialId lowest = MaterialId(1 + step / 400);
+            std::uniform_int_distribution<int> pickMaterial(lowest, lowest + 13);
+            int column = pickColumn(rng);
+            runs.clear();
+            for (int count = pickCount(rng); count > 0; --count) {
+                bool air = rng() % 4 == 0;
+                runs.push_back({ air ? MaterialId(MATERIAL_AIR) : MaterialId(pickMaterial(rng)), pickLength(rng) });
+            }
+
+            std::vector<MaterialId> expected(SIZE, MATERIAL_AIR);
+            for (int y = 0; const VoxelRun& run : runs)
+                for (int i = 0; i < run.length && y < SIZE; ++i) expected[y++] = run.material;
+            std::vector<MaterialId> live;
+            for (int c = 0; c < COLUMNS; ++c)
+                if (c != column) addMaterials(live, &reference[c * SIZE]);
+            addMaterials(live, expected.data());
+
+            bool stored = columns.setColumn(column, runs);
+            CHECK(stored == (live.size() <= ColumnRuns::MAX_MATERIALS),
+                  "step %d: setColumn returned %d with %zu live materials", step, int(stored), live.size());
+            if (stored) std::copy(expected.begin(), expected.end(), reference.begin() + column * SIZE);
+
+            if (step % 500 != 0 && step != 19999) continue;
+            for (int c = 0; c < COLUMNS; ++c) {
+                for (int y = 0; y < SIZE; ++y) {
+                    if (columns.get(c, y) == reference[c * SIZE + y]) continue;
+                    CHECK(false, "step %d: column %d y %d is %u, expected %u", step, c, y,
+                          unsigned(columns.get(c, y)), unsigned(reference[c * SIZE + y]));
+                    return;
+                }
+                columns.getColumn(c, unpacked);
+                int height = 0;
+                for (const VoxelRun& run : unpacked) height += run.length;
+                CHECK(unpacked.empty() || unpacked.back().material != MATERIAL_AIR,
+                      "step %d: column %d unpacks with trailing air", step, c);
+                CHECK(height <= SIZE, "step %d: column %d unpacks %d high", step, c, height);
+            }
+        }
+    }
+
+    struct KeyHash {
+        std::size_t operator()(const glm::ivec3& p) const { return std::size_t(mortonEncode(p)); }
+    };
+    using ReferenceMap = std::unordered_map<glm::ivec3, int, KeyHash>;
+
+    // Every find, findBatch, the size and a full iteration must agree with the reference
+    bool matchesReference(MortonHashMap<int>& map, const ReferenceMap& reference,
+                          const std::vector<glm::ivec3>& universe, const char* when) {
+        int before = g_failures;
+        CHECK(map.size() == reference.size(), "%s: size %zu, expected %zu", when, map.size(), reference.size());
+        for (const glm::ivec3& p : universe) {
+            auto it = reference.find(p);
+            const int* value = map.find(p);
+            CHECK((value != nullptr) == (it != reference.end()) && (!value || *value == it->second),
+                  "%s: find(%d,%d,%d) disagrees", when, p.x, p.y, p.z);
+        }
+
+        // Batches longer than the 16-key prefetch window, present and absent keys mixed
+        std::vector<int*> batch(universe.size());
+        map.findBatch(universe.data(), universe.size(), batch.data());
+        for (std::size_t i = 0; i < universe.size(); ++i)
+            CHECK(batch[i] == map.find(universe[i]), "%s: findBatch entry %zu disagrees with find", when, i);
+
+        std::size_t visited = 0;
+        for (const auto& slot : map) {
+            auto it = reference.find(mortonDecode(slot.key));
+            CHECK(it != reference.end() && it->second == slot.value, "%s: iteration yields a stale entry", when);
+            ++visited;
+        }
+        CHECK(visited == reference.size(), "%s: iteration visits %zu, expected %zu", when, visited, reference.size());
+        return g_failures == before;
+    }
+
+    // Random insert/erase/find against std::unordered_map over a key space small
+    // enough that erases hit and probe runs cluster, plus a table kept at 16 slots
+    // whose keys all hash to its last buckets, so runs wrap round to slot 0 and
+    // backward-shift erase has to move entries across the wrap
+    void checkMortonHashMap(std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<glm::ivec3> universe;
+        for (int x = -6; x < 6; ++x)
+            for (int y = -2; y < 3; ++y)
+                for (int z = -6; z < 6; ++z) universe.emplace_back(x, y, z);
+
+        MortonHashMap<int> map;
+        ReferenceMap reference;
+        std::uniform_int_distribution<std::size_t> pick(0, universe.size() - 1);
+        for (int step = 0; step < 60000; ++step) {
+            const glm::ivec3& p = universe[pick(rng)];
+            switch (rng() % 4) {
+            case 0:
+            case 1: {
+                auto [value, inserted] = map.tryEmplace(p);
+                CHECK(inserted == (reference.count(p) == 0), "step %d: tryEmplace inserted %d", step, int(inserted));
+                *value = step;
+                reference[p] = step;
+                break;
+            }
+            case 2:
+                CHECK(map.erase(p) == (reference.erase(p) == 1), "step %d: erase disagrees", step);
+                break;
+            default: {
+                const int* value = map.find(p);
+                auto it = reference.find(p);
+                CHECK((value != nullptr) == (it != reference.end()) && (!value || *value == it->second),
+                      "step %d: find disagrees", step);
+            }
+            }
+            // Drain now and then so the table also shrinks back through sparse states
+            if (step % 10000 == 9999)
+                while (!reference.empty()) {
+                    glm::ivec3 key = reference.begin()->first;
+                    CHECK(map.erase(key), "step %d: draining erase missed", step);
+                    reference.erase(key);
+                }
+            if (step % 5000 == 0 && !matchesReference(map, reference, universe, "random")) return;
+        }
+        if (!matchesReference(map, reference, universe, "random end")) return;
+
+        // Home buckets of a fresh 16-slot table: the top 4 bits of the Fibonacci hash
+        auto home = [](const glm::ivec3& p) { return int((mortonEncode(p) * 0x9E3779B97F4A7C15ull) >> 60); };
+        std::vector<glm::ivec3> wrapping;
+        for (const glm::ivec3& p : universe)
+            if (home(p) >= 13 && wrapping.size() < 10) wrapping.push_back(p);
+        CHECK(wrapping.size() == 10, "only %zu keys hash to the last buckets", wrapping.size());
+
+        for (int round = 0; round < 200; ++round) {
+            MortonHashMap<int> small;
+            ReferenceMap smallReference;
+            std::vector<glm::ivec3> keys = wrapping;
+            std::shuffle(keys.begin(), keys.end(), rng);
+            for (int i = 0; i < 10; ++i) { // 10 of 16 slots stays under the 0.7 load factor
+                *small.tryEmplace(keys[i]).first = i;
+                smallReference[keys[i]] = i;
+            }
+            // Ten keys homed in buckets 13-15 must spill round into the low slots
+            CHECK(home(mortonDecode(small.begin()->key)) >= 13, "round %d: no probe run wrapped", round);
+
+            std::shuffle(keys.begin(), keys.end(), rng);
+            for (const glm::ivec3& key : keys) {
+                CHECK(small.erase(key), "round %d: erase missed", round);
+                smallReference.erase(key);
+                if (!matchesReference(small, smallReference, wrapping, "wrapped erase")) return;
+            }
+        }
+    }
+
+    struct ChunkContents {
+        std::vector<MaterialId> materials;
+        std::vector<LightLevel> light;
+        std::vector<DamageLevel> damage;
+        bool operator==(const ChunkContents&) const = default;
+    };
+
+    ChunkContents contentsOf(const VoxelChunk& chunk) {
+        ChunkContents contents;
+        for (int x = 0; x < CHUNK_SIZE; ++x)
+            for (int y = 0; y < CHUNK_SIZE; ++y)
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    Voxel voxel = chunk.getVoxel(x, y, z);
+                    contents.materials.push_back(voxel.active ? voxel.material : MaterialId(MATERIAL_AIR));
+                    contents.light.push_back(chunk.getLight(x, y, z));
+                    contents.damage.push_back(chunk.getDamage(x, y, z));
+                }
+        return contents;
+    }
+
+    // Edits one chunk a little at a time (now and then a lot), evicting and
+    // restoring it after each round: every save after the first must append just
+    // the changed bricks until a rewrite is due, and each restore must give back
+    // the chunk as it was evicted. A record torn off the end of the file must
+    // leave the contents of the save before it.
+    void checkBrickSaves() {
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "magma-checks-store";
+        std::filesystem::remove_all(directory);
+        VoxelWorld world;
+        world.generateTerrain(64, 64, 30);
+        world.chunkStore = std::make_unique<ChunkStore>(directory);
+        const glm::ivec3 chunkPos(0, 1, 0);
+        const glm::ivec3 regionPos = ChunkPool::regionOf(chunkPos);
+
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<int> coord(0, CHUNK_SIZE - 1), material(0, 5), level(0, 15);
+        ChunkContents previous;
+        std::size_t rewrites = 0;
+        for (int round = 0; round < 60; ++round) {
+            VoxelChunk* chunk = world.loadChunk(chunkPos);
+            CHECK(chunk != nullptr, "round %d: chunk did not come back", round);
+            if (!chunk) return;
+
+            int edits = round % 15 == 14 ? 300 : 1 + round % 3;
+            for (int i = 0; i < edits; ++i) {
+                int x = coord(rng), y = coord(rng), z = coord(rng);
+                MaterialId m = MaterialId(material(rng));
+                chunk->setVoxel(x, y, z, Voxel{ m != MATERIAL_AIR, m });
+                if (round >= 20) chunk->setLight(x, y, z, LightLevel(level(rng)));
+                if (round >= 40) chunk->setDamage(x, y, z, DamageLevel(level(rng)));
+            }
+            chunk->publish();
+            ChunkContents expected = contentsOf(*chunk);
+
+            std::size_t before = world.residency.getStats().brickFlushes;
+            world.unloadRegion(regionPos);
+            world.chunks.reclaim();
+            bool appended = world.residency.getStats().brickFlushes > before;
+            if (round > 0 && !appended) ++rewrites;
+
+            VoxelChunk* restored = world.loadChunk(chunkPos);
+            CHECK(restored && contentsOf(*restored) == expected, "round %d: restored chunk differs (%s save)",
+                  round, appended ? "brick" : "full");
+            CHECK(restored && !restored->isUnsaved() && restored->isStored(), "round %d: restored chunk unsaved",
+                  round);
+
+            // Tear the last save and the one before must come back
+            if (appended && round % 7 == 3) {
+                world.unloadRegion(regionPos);
+                world.chunks.reclaim();
+                std::filesystem::path file = directory / "0_1_0.chunk";
+                std::filesystem::resize_file(file, std::filesystem::file_size(file) - 5);
+                VoxelChunk* torn = world.loadChunk(chunkPos);
+                CHECK(torn && contentsOf(*torn) == previous, "round %d: torn save not dropped cleanly", round);
+                CHECK(torn && !torn->isStored(), "round %d: appending after a torn save", round);
+                // Put the lost edits back for the next round to build on
+                if (torn) {
+                    for (int x = 0, i = 0; x < CHUNK_SIZE; ++x)
+                        for (int y = 0; y < CHUNK_SIZE; ++y)
+                            for (int z = 0; z < CHUNK_SIZE; ++z, ++i) {
+                                MaterialId m = expected.materials[i];
+                                torn->setVoxel(x, y, z, Voxel{ m != MATERIAL_AIR, m });
+                                torn->setLight(x, y, z, expected.light[i]);
+                                torn->setDamage(x, y, z, expected.damage[i]);
+                            }
+                    torn->publish();
+                }
+            }
+            previous = expected;
+        }
+
+        const ChunkResidency::Stats& stats = world.residency.getStats();
+        CHECK(stats.brickFlushes > 30, "only %zu of %zu saves appended bricks", stats.brickFlushes, stats.flushes);
+        CHECK(rewrites > 0, "the file was never rewritten whole");
+        std::filesystem::remove_all(directory);
+    }
+
+    using MeshFace = std::array<int, 4>; // FaceDirection, then voxel x, y, z
+
+    // The voxel faces a chunk's mesh covers, sorted; each quad must cover voxels of one material
+    template <int Size>
+    std::vector<MeshFace> meshFaces(const BasicVoxelChunk<Size>& chunk) {
+        std::vector<ChunkVertex> mesh;
+        chunk.copyMesh(mesh);
+        std::vector<MeshFace> faces;
+        for (std::size_t q = 0; q + 4 <= mesh.size(); q += 4) {
+            int dir = int(mesh[q] >> 21 & 7), axis = dir / 2;
+            int lo[3] = { INT_MAX, INT_MAX, INT_MAX }, hi[3] = { INT_MIN, INT_MIN, INT_MIN };
+            for (int i = 0; i < 4; ++i) {
+                for (int a = 0; a < 3; ++a) {
+                    int corner = int(mesh[q + i] >> (7 * a) & 127);
+                    lo[a] = std::min(lo[a], corner);
+                    hi[a] = std::max(hi[a], corner);
+                }
+            }
+            // Corners bound the voxels; along the normal a +face sits past its voxel
+            if (dir % 2 == 0) --lo[axis];
+            hi[axis] = lo[axis] + 1;
+            MaterialId material = chunk.getVoxel(lo[0], lo[1], lo[2]).material;
+            for (int x = lo[0]; x < hi[0]; ++x)
+                for (int y = lo[1]; y < hi[1]; ++y)
+                    for (int z = lo[2]; z < hi[2]; ++z) {
+                        faces.push_back({ dir, x, y, z });
+                        CHECK(chunk.getVoxel(x, y, z).material == material, "quad at %d,%d,%d dir %d mixes materials",
+                              lo[0], lo[1], lo[2], dir);
+                    }
+        }
+        std::sort(faces.begin(), faces.end());
+        return faces;
+    }
+
+    // Two copies of a terrain chunk with three material bands take the same
+    // random edits, many on section edges. One refreshes its greedy mesh after
+    // each round, the other rebuilds it whole: the meshes must match exactly,
+    // and cover exactly the faces the per-face mesher emits.
+    template <int Size>
+    void checkGreedyMesh(std::uint32_t seed) {
+        using Chunk = BasicVoxelChunk<Size>;
+        std::mt19937 rng(seed);
+        Chunk refreshed, rebuilt, neighbour;
+        for (Chunk* chunk : { &refreshed, &rebuilt, &neighbour }) {
+            for (int x = 0; x < Size; ++x) {
+                for (int z = 0; z < Size; ++z) {
+                    int height = Size / 4 + (x / 3 + z / 5) % (Size / 2);
+                    VoxelRun runs[3] = { { MATERIAL_STONE, height / 2 }, { MATERIAL_DIRT, height - height / 2 },
+                                         { MATERIAL_GRASS, 1 } };
+                    chunk->setColumnRuns(x, z, runs);
+                }
+            }
+        }
+        // Culled against terrain on the right, kept at the other borders
+        typename Chunk::Neighbours neighbours{};
+        neighbours[int(FaceDirection::Right)] = &neighbour.voxels();
+
+        std::uniform_int_distribution<int> coord(0, Size - 1), edge(0, Size / 4 - 1), material(0, 3);
+        auto pick = [&] {
+            // Half the time on a section edge, where seams are decided
+            int c = coord(rng);
+            return rng() % 2 ? c : edge(rng) * 4 + (rng() % 2 ? 3 : 0);
+        };
+        refreshed.buildMesh(neighbours, MeshMode::Greedy);
+        std::vector<ChunkVertex> a, b;
+        for (int round = 0; round < 150; ++round) {
+            int edits = 1 + int(rng() % 3);
+            for (int i = 0; i < edits; ++i) {
+                int x = pick(), y = pick(), z = pick();
+                MaterialId m = MaterialId(material(rng));
+                for (Chunk* chunk : { &refreshed, &rebuilt })
+                    chunk->setVoxel(x, y, z, Voxel{ m != MATERIAL_AIR, m });
+            }
+            refreshed.refreshMesh(neighbours, MeshMode::Greedy);
+            rebuilt.buildMesh(neighbours, MeshMode::Greedy);
+            refreshed.copyMesh(a);
+            rebuilt.copyMesh(b);
+            CHECK(a == b, "size %d round %d: refreshed mesh has %zu vertices, rebuilt %zu", Size, round, a.size(),
+                  b.size());
+            if (round % 10 != 0) continue;
+
+            // Materials are read from column runs there rather than palette words
+            Chunk packed;
+            for (int x = 0; x < Size; ++x)
+                for (int y = 0; y < Size; ++y)
+                    for (int z = 0; z < Size; ++z) packed.setVoxel(x, y, z, rebuilt.getVoxel(x, y, z));
+            CHECK(packed.compactColumns(), "size %d round %d: chunk does not fit column storage", Size, round);
+            packed.buildMesh(neighbours, MeshMode::Greedy);
+            packed.copyMesh(a);
+            CHECK(a == b, "size %d round %d: column storage meshes to %zu vertices, dense %zu", Size, round, a.size(),
+                  b.size());
+
+            std::vector<MeshFace> greedy = meshFaces(rebuilt);
+            rebuilt.buildMesh(neighbours, MeshMode::Faces);
+            std::vector<MeshFace> faces = meshFaces(rebuilt);
+            CHECK(greedy == faces, "size %d round %d: greedy quads cover %zu faces, per-face mesh %zu", Size, round,
+                  greedy.size(), faces.size());
+            CHECK(b.size() < faces.size() * 4, "size %d round %d: greedy merged nothing", Size, round);
+        }
+    }
+
+    // Freezes a region of generated terrain with a few unsaved edits, compares
+    // getVoxel and downward raycasts against the chunks it replaced, then edits
+    // inside it so it thaws and compares the rebuilt chunks, edits included
+    void checkRegionDag(bool columnStorage) {
+        constexpr int EDGE = ChunkPool::REGION_EDGE * CHUNK_SIZE;
+        VoxelWorld world;
+        world.columnStorage = columnStorage;
+        world.generateTerrain(256, 256, 48);
+        const glm::ivec3 regionPos(-1, 0, 0);
+        const glm::ivec3 origin = regionPos * EDGE;
+
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> pick(0, EDGE - 1);
+        for (int i = 0; i < 200; ++i)
+            world.deactivateVoxel(origin + glm::ivec3(pick(rng), pick(rng) % 48, pick(rng)));
+
+        std::vector<MaterialId> before(std::size_t(EDGE) * EDGE * EDGE);
+        std::vector<glm::ivec3> unsaved;
+        auto sample = [&](std::vector<MaterialId>& out) {
+            for (int x = 0; x < EDGE; ++x)
+                for (int y = 0; y < EDGE; ++y)
+                    for (int z = 0; z < EDGE; ++z) {
+                        std::optional<Voxel> voxel = world.getVoxel(origin + glm::ivec3(x, y, z));
+                        out[(std::size_t(x) * EDGE + y) * EDGE + z] =
+                            voxel && voxel->active ? voxel->material : MaterialId(MATERIAL_AIR);
+                    }
+        };
+        sample(before);
+        world.chunkPool.forEachChunkInRegion(regionPos, [&](VoxelChunk& chunk) {
+            if (chunk.isUnsaved()) unsaved.push_back(chunk.getChunkPos());
+        });
+        CHECK(!unsaved.empty(), "no chunk in the region is unsaved after editing");
+
+        std::size_t frozen = world.freezeRegion(regionPos);
+        world.chunks.reclaim();
+        std::size_t left = 0;
+        world.chunkPool.forEachChunkInRegion(regionPos, [&](VoxelChunk&) { ++left; });
+        CHECK(frozen > 0 && left == 0, "froze %zu chunks, %zu still loaded", frozen, left);
+
+        std::vector<MaterialId> after(before.size());
+        sample(after);
+        for (std::size_t i = 0; i < before.size(); ++i) {
+            if (before[i] == after[i]) continue;
+            CHECK(false, "frozen voxel %zu is %u, was %u", i, unsigned(after[i]), unsigned(before[i]));
+            break;
+        }
+        for (int x = 0; x < EDGE; x += 5) {
+            for (int z = 0; z < EDGE; z += 7) {
+                glm::ivec3 top = origin + glm::ivec3(x, EDGE - 1, z);
+                std::optional<RayHit> hit = world.raycast(glm::vec3(top), glm::vec3(0, -1, 0), float(EDGE));
+                int expected = -1;
+                for (int y = EDGE - 1; y >= 0 && expected < 0; --y)
+                    if (before[(std::size_t(x) * EDGE + y) * EDGE + z] != MATERIAL_AIR) expected = y;
+                int got = hit ? hit->voxel.y - origin.y : -1;
+                CHECK(got == expected, "raycast at %d,%d hit y %d, expected %d", x, z, got, expected);
+            }
+        }
+
+        // Editing thaws the region back into chunks
+        glm::ivec3 edit = origin + glm::ivec3(3, 2, 3);
+        world.deactivateVoxel(edit);
+        before[(std::size_t(3) * EDGE + 2) * EDGE + 3] = MATERIAL_AIR;
+        CHECK(!world.isFrozen(regionPos), "editing left the region frozen");
+        sample(after);
+        for (std::size_t i = 0; i < before.size(); ++i) {
+            if (before[i] == after[i]) continue;
+            CHECK(false, "thawed voxel %zu is %u, was %u", i, unsigned(after[i]), unsigned(before[i]));
+            break;
+        }
+        for (const glm::ivec3& chunkPos : unsaved) {
+            VoxelChunk* chunk = world.getChunk(chunkPos);
+            CHECK(chunk && chunk->isUnsaved(), "chunk %d,%d,%d lost its unsaved edits", chunkPos.x, chunkPos.y,
+                  chunkPos.z);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    // ./magma-checks [section...] runs only the named sections, no arguments runs everything
+    auto wants = [&](const char* section) {
+        if (argc < 2) return true;
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], section) == 0) return true;
+        return false;
+    };
+    auto run = [&](const char* section, auto check) {
+        if (!wants(section)) return;
+        int before = g_failures;
+        check();
+        std::printf("%-10s %s\n", section, g_failures == before ? "ok" : "FAILED");
+    };
+
+    run("palette", [] {
+        for (std::uint32_t seed = 1; seed <= 4; ++seed) checkPaletteStorage(seed);
+    });
+    run("columns", [] {
+        for (std::uint32_t seed = 1; seed <= 4; ++seed) checkColumnRuns(seed);
+    });
+    run("hash", [] {
+        for (std::uint32_t seed = 1; seed <= 4; ++seed) checkMortonHashMap(seed);
+    });
+    run("greedy", [] {
+        for (std::uint32_t seed = 1; seed <= 3; ++seed) {
+            checkGreedyMesh<16>(seed);
+            checkGreedyMesh<32>(seed);
+        }
+    });
+    run("store", [] { checkBrickSaves(); });
+    run("dag", [] {
+        checkRegionDag(false);
+        checkRegionDag(true);
+    });
+    return g_failures == 0 ? 0 : 1;
+}
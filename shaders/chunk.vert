@@ -0,0 +1,28 @@
+#version 330 core
+
+// Packed chunk vertex (ChunkVertex in voxel_chunk.h): voxel corner x, y, z in
+// 7 bits each from bit 0, face direction in bits 21-23
+layout(location = 0) in uint aPacked;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// FaceDirection order: right, left, top, bottom, front, back
+const vec3 normals[6] = vec3[6](
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0)
+);
+
+void main() {
+    vec3 corner = vec3(aPacked & 127u, (aPacked >> 7) & 127u, (aPacked >> 14) & 127u);
+    // Voxels are centred on integer coordinates, so their corners sit half a voxel off
+    FragPos = vec3(model * vec4(corner - 0.5, 1.0));
+    // Chunk model matrices only translate, so normals need no transform
+    Normal = normals[int((aPacked >> 21) & 7u)];
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,58 @@
+// brick_versions.cpp
+#include "brick_versions.h"
+
+template <int Size>
+BrickVersions<Size>::BrickVersions(const BrickVersions& other)
+    : brickVersion(other.brickVersion ? std::make_unique<Stamps>(*other.brickVersion) : nullptr),
+      version(other.version), allVersion(other.allVersion) {
+}
+
+template <int Size>
+BrickVersions<Size>& BrickVersions<Size>::operator=(const BrickVersions& other) {
+    if (this != &other) {
+        brickVersion = other.brickVersion ? std::make_unique<Stamps>(*other.brickVersion) : nullptr;
+        version = other.version;
+        allVersion = other.allVersion;
+    }
+    return *this;
+}
+
+template <int Size>
+auto BrickVersions<Size>::stamps() -> Stamps& {
+    if (!brickVersion) {
+        brickVersion = std::make_unique<Stamps>();
+        brickVersion->fill(allVersion);
+    }
+    return *brickVersion;
+}
+
+template <int Size>
+void BrickVersions<Size>::markColumn(int x, int z, int yBegin, int yEnd) {
+    Stamps& stamp = stamps();
+    ++version;
+    for (int by = yBegin / BRICK; by * BRICK < yEnd; ++by)
+        stamp[brickIndex(x / BRICK, by, z / BRICK)] = version;
+}
+
+template <int Size>
+void BrickVersions<Size>::markAll() {
+    allVersion = ++version;
+    brickVersion.reset();
+}
+
+template <int Size>
+auto BrickVersions<Size>::changedSince(std::uint32_t seen) const -> Mask {
+    Mask changed;
+    if (version == seen) return changed;
+    if (!brickVersion) {
+        if (allVersion > seen) changed.set();
+        return changed;
+    }
+    for (int i = 0; i < COUNT; ++i)
+        if ((*brickVersion)[i] > seen) changed.set(i);
+    return changed;
+}
+
+template class BrickVersions<16>;
+template class BrickVersions<32>;
+template class BrickVersions<64>;
@@ -0,0 +1,58 @@
+// brick_versions.h
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Change tracking for a Size^3 chunk at 4^3-brick granularity (the bricks of
+// OccupancySummary). Every change bumps the chunk's version and stamps the
+// bricks it touched with it, so any number of consumers (the mesher, the saver,
+// a replicator reading snapshots) can each remember the version they last saw
+// and ask for exactly the bricks that changed since, without the chunk knowing
+// about them. Versions only grow while the contents live; a pool reset starts
+// the chunk over at 0 and its consumers with it.
+//
+// The stamps live in a separate block, allocated by the first change that is
+// not to every brick at once: markAll frees it again, so generated and loaded
+// chunks that are never edited carry no stamps, only the two versions.
+template <int Size>
+class BrickVersions {
+public:
+    static constexpr int BRICK = 4;
+    static constexpr int BRICKS = Size / BRICK; // Per axis
+    static constexpr int COUNT = BRICKS * BRICKS * BRICKS;
+    // Bit (bx * BRICKS + by) * BRICKS + bz, so the bricks of one (bx, by) column are adjacent
+    using Mask = std::bitset<COUNT>;
+
+    BrickVersions() = default;
+    BrickVersions(const BrickVersions& other);
+    BrickVersions& operator=(const BrickVersions& other);
+    BrickVersions(BrickVersions&&) = default;
+    BrickVersions& operator=(BrickVersions&&) = default;
+
+    static int brickIndex(int bx, int by, int bz) { return (bx * BRICKS + by) * BRICKS + bz; }
+
+    // Voxel (x, y, z) changed
+    void mark(int x, int y, int z) { stamps()[brickIndex(x / BRICK, y / BRICK, z / BRICK)] = ++version; }
+    // Voxels [yBegin, yEnd) of column (x, z) changed
+    void markColumn(int x, int z, int yBegin, int yEnd);
+    // Every brick changed; also what to call once contents were rebuilt whole
+    void markAll();
+
+    std::uint32_t getVersion() const { return version; }
+    // Bricks changed after version `seen`; all of them for seen == 0 once anything changed
+    Mask changedSince(std::uint32_t seen) const;
+    std::size_t memoryUsage() const { return brickVersion ? sizeof(Stamps) : 0; }
+
+private:
+    using Stamps = std::array<std::uint32_t, COUNT>;
+
+    std::unique_ptr<Stamps> brickVersion; // Null while every brick carries allVersion
+    std::uint32_t version = 0;
+    std::uint32_t allVersion = 0;         // Version of the last markAll
+
+    Stamps& stamps();
+};
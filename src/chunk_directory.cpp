@@ -0,0 +1,38 @@
+// chunk_directory.cpp
+#include "chunk_directory.h"
+
+VoxelChunk* ChunkDirectory::get(const glm::ivec3& chunkPos) const {
+    const Shard& shard = shardFor(chunkPos);
+    std::shared_lock lock(shard.mutex);
+    const ChunkPool::Handle* handle = shard.chunks.find(chunkPos);
+    return handle ? handle->get() : nullptr;
+}
+
+bool ChunkDirectory::erase(const glm::ivec3& chunkPos) {
+    Shard& shard = shardFor(chunkPos);
+    std::unique_lock lock(shard.mutex);
+    ChunkPool::Handle* handle = shard.chunks.find(chunkPos);
+    if (!handle) return false;
+
+    ChunkPool::retire(*handle); // Out of the pool's visitors too
+    shard.retired.push_back(std::move(*handle));
+    shard.chunks.erase(chunkPos);
+    count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ChunkDirectory::reclaim() {
+    for (Shard& shard : shards) {
+        std::unique_lock lock(shard.mutex);
+        shard.retired.clear();
+    }
+}
+
+std::size_t ChunkDirectory::memoryUsage() const {
+    std::size_t bytes = sizeof(ChunkDirectory);
+    for (const Shard& shard : shards) {
+        std::shared_lock lock(shard.mutex);
+        bytes += shard.chunks.memoryUsage() + shard.retired.capacity() * sizeof(ChunkPool::Handle);
+    }
+    return bytes;
+}
@@ -0,0 +1,88 @@
+// chunk_directory.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk_pool.h"
+#include "morton_hash_map.h"
+
+// Thread-safe map from chunk coordinate to chunk, split into SHARD_COUNT
+// independently locked MortonHashMaps. Lookups take their shard's lock shared,
+// inserts and erases take it exclusively, so threads working on different
+// parts of the world rarely meet on the same lock.
+//
+// Erased chunks are retired rather than returned to the pool straight away, so
+// a pointer from get/getOrCreate stays valid until the next reclaim(), which
+// the owner calls at a point where no other thread is holding one (once per
+// frame). The directory guards the map only: a chunk's contents follow
+// VoxelChunk's single-writer rules, and other threads should read snapshot()s.
+class ChunkDirectory {
+public:
+    static constexpr int SHARD_BITS = 6;
+    static constexpr std::size_t SHARD_COUNT = std::size_t(1) << SHARD_BITS;
+
+    VoxelChunk* get(const glm::ivec3& chunkPos) const;
+
+    // Returns the chunk at chunkPos, calling create() (under the shard lock) to
+    // make a ChunkPool::Handle if there is none yet
+    template <typename Create>
+    VoxelChunk& getOrCreate(const glm::ivec3& chunkPos, Create&& create) {
+        if (VoxelChunk* chunk = get(chunkPos)) return *chunk;
+
+        Shard& shard = shardFor(chunkPos);
+        std::unique_lock lock(shard.mutex);
+        auto [handle, inserted] = shard.chunks.tryEmplace(chunkPos);
+        if (inserted) {
+            *handle = create();
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        return **handle;
+    }
+
+    bool erase(const glm::ivec3& chunkPos);
+    // Hands chunks erased since the last call back to their pool
+    void reclaim();
+
+    // Visits every chunk, one shard at a time under that shard's shared lock.
+    // fn must not insert into or erase from the directory.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Shard& shard : shards) {
+            std::shared_lock lock(shard.mutex);
+            for (const auto& [key, handle] : shard.chunks)
+                fn(*handle);
+        }
+    }
+
+    std::size_t size() const { return count.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+    std::size_t memoryUsage() const;
+
+private:
+    // Padded to a cache line so neighbouring shard locks do not false-share
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        MortonHashMap<ChunkPool::Handle> chunks;
+        std::vector<ChunkPool::Handle> retired; // Erased, waiting for reclaim()
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+    std::atomic<std::size_t> count{ 0 };
+
+    // The maps bucket on the top bits of a Fibonacci hash, so shards use a different mix
+    static std::size_t shardIndex(const glm::ivec3& chunkPos) {
+        std::uint64_t key = mortonEncode(chunkPos);
+        key ^= key >> 31;
+        key *= 0xBF58476D1CE4E5B9ull;
+        return std::size_t(key ^ (key >> 29)) & (SHARD_COUNT - 1);
+    }
+
+    Shard& shardFor(const glm::ivec3& chunkPos) { return shards[shardIndex(chunkPos)]; }
+    const Shard& shardFor(const glm::ivec3& chunkPos) const { return shards[shardIndex(chunkPos)]; }
+};
@@ -0,0 +1,133 @@
+// chunk_pool.cpp
+#include "chunk_pool.h"
+
+#include <algorithm>
+
+ChunkPool::Handle ChunkPool::acquire(const glm::ivec3& chunkPos) {
+    std::lock_guard lock(mutex);
+    auto [region, inserted] = regions.tryEmplace(regionOf(chunkPos));
+    if (inserted) {
+        if (!spareRegions.empty()) {
+            *region = std::move(spareRegions.back());
+            spareRegions.pop_back();
+            ++stats.recycled;
+        } else {
+            *region = std::make_unique<Region>();
+            stats.capacity += REGION_CHUNKS;
+        }
+        ++stats.regions;
+    }
+
+    VoxelChunk* chunk;
+    int slot = slotIndex(chunkPos);
+    if (!(*region)->acquired[slot]) {
+        (*region)->acquired.set(slot);
+        (*region)->live.set(slot);
+        chunk = &(*region)->slots[slot];
+    } else {
+        if (overflowFree.empty()) {
+            overflow.push_back(std::make_unique<VoxelChunk>());
+            overflowFree.push_back(overflow.back().get());
+            ++stats.capacity;
+        }
+        chunk = overflowFree.back();
+        overflowFree.pop_back();
+        overflowLive.push_back(chunk);
+        ++stats.overflow;
+    }
+
+    chunk->reset(chunkPos);
+    ++stats.acquires;
+    stats.highWater = std::max(stats.highWater, ++stats.inUse);
+    return Handle(chunk, Releaser{ this });
+}
+
+void ChunkPool::retire(const Handle& handle) {
+    ChunkPool& pool = *handle.get_deleter().pool;
+    std::lock_guard lock(pool.mutex);
+    pool.hide(handle.get());
+}
+
+void ChunkPool::hide(VoxelChunk* chunk) {
+    int slot;
+    if (Region* region = regionHolding(chunk, slot)) {
+        region->live.reset(slot);
+        return;
+    }
+    auto it = std::find(overflowLive.begin(), overflowLive.end(), chunk);
+    if (it != overflowLive.end()) overflowLive.erase(it);
+}
+
+void ChunkPool::reserve(std::size_t count) {
+    std::lock_guard lock(mutex);
+    while (stats.regions + spareRegions.size() < count) {
+        spareRegions.push_back(std::make_unique<Region>());
+        stats.capacity += REGION_CHUNKS;
+    }
+}
+
+void ChunkPool::shrink() {
+    std::lock_guard lock(mutex);
+    stats.capacity -= spareRegions.size() * REGION_CHUNKS;
+    spareRegions.clear();
+    spareRegions.shrink_to_fit();
+}
+
+ChunkPool::Region* ChunkPool::regionHolding(const VoxelChunk* chunk, int& slot) {
+    // A released chunk keeps its position, so its region is found by position
+    std::unique_ptr<Region>* region = regions.find(regionOf(chunk->getChunkPos()));
+    if (!region) return nullptr;
+    const VoxelChunk* first = (*region)->slots.get();
+    if (chunk < first || chunk >= first + REGION_CHUNKS) return nullptr;
+    slot = int(chunk - first);
+    return region->get();
+}
+
+void ChunkPool::release(VoxelChunk* chunk) {
+    // Out of the visitors first, then free the contents now rather than on reuse,
+    // so unloading actually returns memory
+    {
+        std::lock_guard lock(mutex);
+        hide(chunk);
+    }
+    chunk->reset(chunk->getChunkPos());
+    std::lock_guard lock(mutex);
+    --stats.inUse;
+
+    int slot;
+    glm::ivec3 regionPos = regionOf(chunk->getChunkPos());
+    if (Region* region = regionHolding(chunk, slot)) {
+        region->acquired.reset(slot);
+        if (region->acquired.none()) {
+            // Whole region released: keep it, GL handles and all, for the next new region
+            spareRegions.push_back(std::move(*regions.find(regionPos)));
+            regions.erase(regionPos);
+            --stats.regions;
+        }
+        return;
+    }
+    overflowFree.push_back(chunk);
+}
+
+ChunkPool::Stats ChunkPool::getStats() const {
+    std::lock_guard lock(mutex);
+    Stats result = stats;
+    result.spareRegions = spareRegions.size();
+    return result;
+}
+
+std::size_t ChunkPool::memoryUsage() const {
+    std::lock_guard lock(mutex);
+    std::size_t bytes = regions.memoryUsage() +
+                        (overflowFree.capacity() + overflowLive.capacity()) * sizeof(VoxelChunk*) +
+                        (spareRegions.capacity() + overflow.capacity()) * sizeof(void*);
+    auto addRegion = [&](const Region& region) {
+        bytes += sizeof(Region);
+        for (int i = 0; i < REGION_CHUNKS; ++i)
+            bytes += region.slots[i].memoryUsage();
+    };
+    for (const auto& [key, region] : regions) addRegion(*region);
+    for (const auto& region : spareRegions) addRegion(*region);
+    for (const auto& chunk : overflow) bytes += chunk->memoryUsage();
+    return bytes;
+}
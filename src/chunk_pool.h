@@ -0,0 +1,119 @@
+// chunk_pool.h
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxel_chunk.h"
+#include "morton_hash_map.h"
+
+// Region allocator for VoxelChunk. Chunks live in regions of REGION_EDGE^3
+// neighbouring chunk positions, each region one contiguous array of chunks in
+// Z-order of their local position, so walking neighbouring chunks walks memory
+// linearly. Chunks are never destroyed individually: a released chunk drops its
+// voxel contents and mesh copy but keeps its GL handles, and a region whose
+// chunks are all released is kept as a spare and reused whole, GL handles
+// included, for the next new region. Spares are only freed by shrink() or with
+// the pool. acquire, release and the visitors may be called from any thread.
+class ChunkPool {
+public:
+    static constexpr int REGION_BITS = 3;
+    static constexpr int REGION_EDGE = 1 << REGION_BITS;
+    static constexpr int REGION_CHUNKS = REGION_EDGE * REGION_EDGE * REGION_EDGE;
+
+    // Deleter that hands the chunk back to its pool instead of freeing it
+    struct Releaser {
+        ChunkPool* pool = nullptr;
+        void operator()(VoxelChunk* chunk) const { if (chunk) pool->release(chunk); }
+    };
+    using Handle = std::unique_ptr<VoxelChunk, Releaser>;
+
+    struct Stats {
+        std::size_t capacity = 0;  // Chunks constructed across all regions and overflow
+        std::size_t inUse = 0;
+        std::size_t highWater = 0; // Peak inUse, for sizing the pool per deployment
+        std::size_t regions = 0;   // Holding at least one chunk
+        std::size_t spareRegions = 0;
+        std::size_t acquires = 0;
+        std::size_t recycled = 0;  // Regions served from the spares
+        std::size_t overflow = 0;  // Acquires whose slot was still held, see acquire
+    };
+
+    ChunkPool() = default;
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    static glm::ivec3 regionOf(const glm::ivec3& chunkPos) { return chunkPos >> REGION_BITS; }
+
+    // Hands out the chunk in chunkPos's slot of its region. If that slot is still
+    // held (a retired chunk at the same position, waiting to be released) the
+    // chunk comes from a small overflow list instead.
+    Handle acquire(const glm::ivec3& chunkPos);
+    // Takes a chunk out of the visitors below while its handle stays alive, for
+    // ChunkDirectory::erase; the chunk is released when the handle goes
+    static void retire(const Handle& handle);
+    // Constructs spare regions up front so the first `regions` never allocate
+    void reserve(std::size_t regions);
+    // Frees the spare regions; call with a GL context current
+    void shrink();
+
+    // Visits every acquired, unretired chunk, region by region in address order.
+    // Holds the pool lock: fn must not acquire, release or retire chunks.
+    template <typename Fn>
+    void forEachChunk(Fn&& fn) const {
+        std::lock_guard lock(mutex);
+        for (const auto& [key, region] : regions)
+            visitRegion(*region, fn);
+        for (VoxelChunk* chunk : overflowLive)
+            fn(*chunk);
+    }
+
+    // The same for one region's chunks only
+    template <typename Fn>
+    void forEachChunkInRegion(const glm::ivec3& regionPos, Fn&& fn) const {
+        std::lock_guard lock(mutex);
+        if (const auto* region = regions.find(regionPos))
+            visitRegion(**region, fn);
+        for (VoxelChunk* chunk : overflowLive)
+            if (regionOf(chunk->getChunkPos()) == regionPos) fn(*chunk);
+    }
+
+    Stats getStats() const;
+    std::size_t memoryUsage() const;
+
+private:
+    struct Region {
+        std::unique_ptr<VoxelChunk[]> slots = std::make_unique<VoxelChunk[]>(REGION_CHUNKS);
+        std::bitset<REGION_CHUNKS> acquired; // Handed out and not yet released
+        std::bitset<REGION_CHUNKS> live;     // Acquired and not retired
+    };
+
+    mutable std::mutex mutex;
+    MortonHashMap<std::unique_ptr<Region>> regions;      // Keyed by regionOf(chunkPos)
+    std::vector<std::unique_ptr<Region>> spareRegions;
+    std::vector<std::unique_ptr<VoxelChunk>> overflow;  // Every overflow chunk ever made
+    std::vector<VoxelChunk*> overflowFree;
+    std::vector<VoxelChunk*> overflowLive;
+    Stats stats;
+
+    // Z-order of the chunk inside its region, so the 2^3 chunks around a point share memory
+    static int slotIndex(const glm::ivec3& chunkPos) {
+        glm::ivec3 local = chunkPos & (REGION_EDGE - 1);
+        return int(mortonSpread(local.x) | mortonSpread(local.y) << 1 | mortonSpread(local.z) << 2);
+    }
+
+    template <typename Fn>
+    static void visitRegion(const Region& region, Fn& fn) {
+        if (region.live.none()) return;
+        for (int i = 0; i < REGION_CHUNKS; ++i)
+            if (region.live[i]) fn(region.slots[i]);
+    }
+
+    // Both with the lock held
+    Region* regionHolding(const VoxelChunk* chunk, int& slot);
+    void hide(VoxelChunk* chunk); // Drops the chunk from the visitors
+    void release(VoxelChunk* chunk);
+};
@@ -0,0 +1,143 @@
+// chunk_residency.cpp
+#include "chunk_residency.h"
+#include "voxel_world.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+VoxelChunk* ChunkResidency::lookup(VoxelWorld& world, const glm::ivec3& chunkPos) {
+    if (VoxelChunk* chunk = world.getChunk(chunkPos)) {
+        ++stats.hits;
+        touch(*chunk);
+        return chunk;
+    }
+    return restore(world, chunkPos);
+}
+
+void ChunkResidency::touch(VoxelChunk& chunk) const {
+    chunk.lastAccess = frame;
+}
+
+VoxelChunk* ChunkResidency::restore(VoxelWorld& world, const glm::ivec3& chunkPos) {
+    if (!isEvicted(chunkPos)) return nullptr;
+
+    VoxelChunk* chunk = nullptr;
+    if (world.chunkStore && world.chunkStore->contains(chunkPos)) {
+        VoxelChunk& loaded = world.getOrCreateChunk(chunkPos);
+        if (!world.chunkStore->load(chunkPos, loaded)) {
+            // Regenerating would silently drop the saved edits; stay evicted instead
+            world.unloadChunk(chunkPos);
+            ++stats.loadFailures;
+            return nullptr;
+        }
+        chunk = &loaded;
+    }
+    evicted.erase(chunkPos);
+    ++stats.misses;
+
+    // Overlay edits made since the chunk was last saved whole
+    if (chunk && world.edits.apply(*chunk)) {
+        chunk->markSaved();
+        chunk->publish();
+    }
+    if (!chunk) chunk = world.generateChunk(chunkPos);
+
+    if (chunk) touch(*chunk);
+    return chunk;
+}
+
+bool ChunkResidency::flush(VoxelWorld& world, VoxelChunk& chunk) {
+    if (!chunk.isUnsaved()) return true;
+    if (!world.chunkStore) return false;
+
+    // A chunk whose file is current only needs its changed bricks appended
+    const glm::ivec3& chunkPos = chunk.getChunkPos();
+    if (chunk.isStored() && world.chunkStore->saveBricks(chunkPos, chunk.voxels(), chunk.unsavedBricks())) {
+        ++stats.brickFlushes;
+    } else if (!world.chunkStore->save(chunkPos, chunk.voxels())) {
+        return false;
+    }
+    chunk.markStored();
+    ++stats.flushes;
+    return true;
+}
+
+void ChunkResidency::evict(VoxelWorld& world, const glm::ivec3& chunkPos) {
+    world.unloadChunk(chunkPos);
+    evicted[chunkPos] = true;
+    ++stats.evictions;
+}
+
+void ChunkResidency::trim(VoxelWorld& world) {
+    std::size_t resident = 0;
+    std::vector<std::pair<std::uint64_t, VoxelChunk*>> candidates;
+    world.chunkPool.forEachChunk([&](VoxelChunk& chunk) {
+        resident += chunk.memoryUsage();
+        if (chunk.lastAccess < frame) candidates.emplace_back(chunk.lastAccess, &chunk);
+    });
+
+    if (budgetBytes != 0 && resident > budgetBytes) {
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (const auto& [lastAccess, chunk] : candidates) {
+            if (resident <= budgetBytes) break;
+
+            // Edits only exist in memory, so they go to disk before the chunk may leave
+            if (!flush(world, *chunk)) continue;
+            resident -= chunk->memoryUsage();
+            evict(world, chunk->getChunkPos());
+        }
+    }
+    // Evicted chunks were only retired; no other thread may hold them past the frame
+    world.chunks.reclaim();
+    stats.bytesResident = resident;
+
+    double windowSecs = std::chrono::duration<double>(Clock::now() - rateWindowStart).count();
+    if (windowSecs >= 1.0) {
+        stats.evictionsPerSecond = double(stats.evictions - rateWindowEvictions) / windowSecs;
+        rateWindowEvictions = stats.evictions;
+        rateWindowStart = Clock::now();
+    }
+    ++frame;
+}
+
+namespace {
+    // The region's chunks in pool (address) order; the pool lock is not held afterwards
+    std::vector<VoxelChunk*> regionChunks(VoxelWorld& world, const glm::ivec3& regionPos) {
+        std::vector<VoxelChunk*> list;
+        world.chunkPool.forEachChunkInRegion(regionPos, [&](VoxelChunk& chunk) { list.push_back(&chunk); });
+        return list;
+    }
+}
+
+std::size_t ChunkResidency::saveRegion(VoxelWorld& world, const glm::ivec3& regionPos) {
+    std::size_t saved = 0;
+    for (VoxelChunk* chunk : regionChunks(world, regionPos))
+        if (chunk->isUnsaved() && flush(world, *chunk)) ++saved;
+    return saved;
+}
+
+std::size_t ChunkResidency::evictRegion(VoxelWorld& world, const glm::ivec3& regionPos) {
+    std::size_t count = 0;
+    for (VoxelChunk* chunk : regionChunks(world, regionPos)) {
+        if (!flush(world, *chunk)) continue;
+        evict(world, chunk->getChunkPos());
+        ++count;
+    }
+    return count;
+}
+
+std::size_t ChunkResidency::restoreRegion(VoxelWorld& world, const glm::ivec3& regionPos) {
+    std::size_t count = 0;
+    glm::ivec3 origin = regionPos * ChunkPool::REGION_EDGE;
+    for (int x = 0; x < ChunkPool::REGION_EDGE; ++x)
+        for (int y = 0; y < ChunkPool::REGION_EDGE; ++y)
+            for (int z = 0; z < ChunkPool::REGION_EDGE; ++z)
+                if (VoxelChunk* chunk = restore(world, origin + glm::ivec3(x, y, z))) {
+                    touch(*chunk);
+                    ++count;
+                }
+    return count;
+}
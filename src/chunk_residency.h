@@ -0,0 +1,75 @@
+// chunk_residency.h
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "morton_hash_map.h"
+
+class VoxelWorld;
+class VoxelChunk;
+
+// Keeps the world's resident chunk bytes under a budget. Every lookup stamps
+// the chunk with the current frame; trim() evicts the least recently used
+// chunks until the world fits, saving edited ones to the world's ChunkStore
+// first (edited chunks stay resident when there is no store). A lookup of an
+// evicted chunk reloads it from the store, or regenerates it from the terrain
+// settings if it was never saved, then replays the world's overlay edits (so
+// with VoxelWorld::overlayStorage, edited chunks evict without a store too).
+// A saved file that fails to load is never replaced by regenerated terrain:
+// the chunk stays evicted and the failure is counted in Stats::loadFailures.
+class ChunkResidency {
+public:
+    struct Stats {
+        std::size_t hits = 0;            // Lookups served by a resident chunk (once per chunk per raycast)
+        std::size_t misses = 0;          // Lookups that restored an evicted chunk
+        std::size_t loadFailures = 0;    // Restores whose saved file was unreadable
+        std::size_t evictions = 0;
+        std::size_t flushes = 0;         // Edited chunks saved on their way out
+        std::size_t brickFlushes = 0;    // Of those, saved by appending changed bricks only
+        std::size_t bytesResident = 0;   // As of the last trim
+        double evictionsPerSecond = 0.0; // Averaged over roughly the last second
+
+        double hitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 1.0; }
+    };
+
+    std::size_t budgetBytes = 0; // 0 = unlimited
+
+    // Resident chunk at chunkPos, restoring it if it was evicted; nullptr if it
+    // never existed or its saved file could not be loaded
+    VoxelChunk* lookup(VoxelWorld& world, const glm::ivec3& chunkPos);
+    // Marks a chunk as used this frame without counting a lookup (e.g. it was drawn)
+    void touch(VoxelChunk& chunk) const;
+    // Ends the frame: evicts chunks not used during it until the world fits the budget
+    void trim(VoxelWorld& world);
+
+    // Bulk versions for one ChunkPool region (see ChunkPool::regionOf), walked in
+    // address order. saveRegion writes the region's edited chunks to the store;
+    // evictRegion saves and evicts all of them, so the region goes back to the
+    // pool whole at the next reclaim (edited chunks that could not be saved
+    // stay); restoreRegion brings every evicted chunk of the region back.
+    // Each returns the number of chunks it handled.
+    std::size_t saveRegion(VoxelWorld& world, const glm::ivec3& regionPos);
+    std::size_t evictRegion(VoxelWorld& world, const glm::ivec3& regionPos);
+    std::size_t restoreRegion(VoxelWorld& world, const glm::ivec3& regionPos);
+
+    bool isEvicted(const glm::ivec3& chunkPos) const { return evicted.find(chunkPos) != nullptr; }
+    // Keyed by the Morton code of the chunk position (see mortonDecode)
+    const MortonHashMap<bool>& getEvicted() const { return evicted; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    MortonHashMap<bool> evicted; // Used as a set
+    std::uint64_t frame = 1;
+    Stats stats;
+    Clock::time_point rateWindowStart = Clock::now();
+    std::size_t rateWindowEvictions = 0;
+
+    VoxelChunk* restore(VoxelWorld& world, const glm::ivec3& chunkPos);
+    // Saves an edited chunk; false if it is edited and there is no store or the save failed
+    bool flush(VoxelWorld& world, VoxelChunk& chunk);
+    void evict(VoxelWorld& world, const glm::ivec3& chunkPos);
+};
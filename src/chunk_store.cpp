@@ -0,0 +1,358 @@
+// chunk_store.cpp
+#include "chunk_store.h"
+#include "voxel_chunk.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+    // MVC1 files hold the columns and channels only. MVC2 adds the byte size of
+    // that part after the magic, and may be followed by appended brick records.
+    constexpr char MAGIC_V1[4] = { 'M', 'V', 'C', '1' };
+    constexpr char MAGIC[4] = { 'M', 'V', 'C', '2' };
+    constexpr int BRICK = BrickVersions<CHUNK_SIZE>::BRICK;
+    constexpr int BRICKS = BrickVersions<CHUNK_SIZE>::BRICKS;
+    constexpr int BRICK_VOLUME = BRICK * BRICK * BRICK;
+
+    // Per column: run count, then (material, length) per run, bottom-up with trailing air omitted
+    struct SavedRun {
+        std::uint16_t material;
+        std::uint8_t length;
+    };
+
+    // After the columns, one byte per attribute channel saying whether it
+    // follows, then CHUNK_VOLUME values in x, y, z order. Files without the
+    // trailer predate channels and load with none.
+    enum SavedChannel : std::uint8_t {
+        SAVED_LIGHT = 1,
+        SAVED_DAMAGE = 2
+    };
+
+    // Each saveBricks call appends its brick count, then per brick its index (see
+    // BrickVersions::brickIndex), which channels follow, and BRICK^3 materials and
+    // channel values in x, y, z order. Saves replay in file order over the
+    // contents before them.
+    struct SavedBrick {
+        std::uint16_t brick;
+        std::uint8_t channels;
+    };
+
+    std::size_t brickRecordBytes(std::uint8_t channels) {
+        return sizeof(SavedBrick::brick) + sizeof(SavedBrick::channels) + BRICK_VOLUME * sizeof(MaterialId) +
+               (channels & SAVED_LIGHT ? BRICK_VOLUME * sizeof(LightLevel) : 0) +
+               (channels & SAVED_DAMAGE ? BRICK_VOLUME * sizeof(DamageLevel) : 0);
+    }
+
+    template <typename Fn>
+    void forEachBrickVoxel(int brick, Fn fn) {
+        int bx = brick / (BRICKS * BRICKS), by = brick / BRICKS % BRICKS, bz = brick % BRICKS;
+        for (int x = bx * BRICK; x < bx * BRICK + BRICK; ++x)
+            for (int y = by * BRICK; y < by * BRICK + BRICK; ++y)
+                for (int z = bz * BRICK; z < bz * BRICK + BRICK; ++z)
+                    fn(x, y, z);
+    }
+
+    std::uint8_t savedChannels(const ChunkVoxels& voxels) {
+        return (voxels.getLightChannel().isAllocated() ? SAVED_LIGHT : 0) |
+               (voxels.getDamageChannel().isAllocated() ? SAVED_DAMAGE : 0);
+    }
+
+    // The overlay file: chunk count, then per chunk its position, edit count
+    // and (index, material) pairs as EditOverlay keeps them
+    constexpr char OVERLAY_MAGIC[4] = { 'M', 'V', 'E', '1' };
+
+    struct SavedOverlayChunk {
+        std::int32_t pos[3];
+        std::uint16_t count;
+    };
+
+    template <typename T, typename Get>
+    void writeChannel(std::ofstream& out, Get get) {
+        std::vector<T> values;
+        values.reserve(CHUNK_VOLUME);
+        for (int x = 0; x < CHUNK_SIZE; ++x)
+            for (int y = 0; y < CHUNK_SIZE; ++y)
+                for (int z = 0; z < CHUNK_SIZE; ++z)
+                    values.push_back(get(x, y, z));
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    bool readChannel(std::ifstream& in, std::vector<T>& values) {
+        values.resize(CHUNK_VOLUME);
+        return bool(in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T)));
+    }
+
+    template <typename T, typename Set>
+    void applyChannel(const std::vector<T>& values, Set set) {
+        if (values.empty()) return;
+        int i = 0;
+        for (int x = 0; x < CHUNK_SIZE; ++x)
+            for (int y = 0; y < CHUNK_SIZE; ++y)
+                for (int z = 0; z < CHUNK_SIZE; ++z)
+                    set(x, y, z, values[i++]);
+    }
+}
+
+ChunkStore::ChunkStore(std::filesystem::path directory) : directory(std::move(directory)) {
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+}
+
+std::filesystem::path ChunkStore::pathFor(const glm::ivec3& chunkPos) const {
+    return directory / (std::to_string(chunkPos.x) + "_" + std::to_string(chunkPos.y) + "_" +
+                        std::to_string(chunkPos.z) + ".chunk");
+}
+
+bool ChunkStore::contains(const glm::ivec3& chunkPos) const {
+    std::error_code error;
+    return std::filesystem::exists(pathFor(chunkPos), error);
+}
+
+template <typename Write>
+bool ChunkStore::writeFile(const std::filesystem::path& path, Write write) const {
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        write(out);
+        if (!out) return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    return !error;
+}
+
+bool ChunkStore::save(const glm::ivec3& chunkPos, const ChunkVoxels& voxels) const {
+    return writeFile(pathFor(chunkPos), [&](std::ofstream& out) {
+        out.write(MAGIC, sizeof(MAGIC));
+        std::uint32_t baseBytes = 0; // Patched in once the columns and channels are written
+        out.write(reinterpret_cast<const char*>(&baseBytes), sizeof(baseBytes));
+
+        std::vector<SavedRun> runs;
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                runs.clear();
+                for (int y = 0; y < CHUNK_SIZE; ++y) {
+                    MaterialId material = voxels.getVoxel(x, y, z).material;
+                    if (!runs.empty() && runs.back().material == material) ++runs.back().length;
+                    else runs.push_back({ material, 1 });
+                }
+                if (runs.back().material == MATERIAL_AIR) runs.pop_back();
+
+                std::uint8_t count = std::uint8_t(runs.size());
+                out.write(reinterpret_cast<const char*>(&count), 1);
+                for (const SavedRun& run : runs) {
+                    out.write(reinterpret_cast<const char*>(&run.material), sizeof(run.material));
+                    out.write(reinterpret_cast<const char*>(&run.length), sizeof(run.length));
+                }
+            }
+        }
+
+        std::uint8_t channels = savedChannels(voxels);
+        out.write(reinterpret_cast<const char*>(&channels), 1);
+        if (channels & SAVED_LIGHT)
+            writeChannel<LightLevel>(out, [&](int x, int y, int z) { return voxels.getLight(x, y, z); });
+        if (channels & SAVED_DAMAGE)
+            writeChannel<DamageLevel>(out, [&](int x, int y, int z) { return voxels.getDamage(x, y, z); });
+
+        baseBytes = std::uint32_t(out.tellp());
+        out.seekp(sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&baseBytes), sizeof(baseBytes));
+    });
+}
+
+bool ChunkStore::saveBricks(const glm::ivec3& chunkPos, const ChunkVoxels& voxels, const BrickMask& bricks) const {
+    std::filesystem::path path = pathFor(chunkPos);
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    std::uint32_t baseBytes = 0;
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC) ||
+        !file.read(reinterpret_cast<char*>(&baseBytes), sizeof(baseBytes)))
+        return false;
+
+    // Once the records would outgrow the full save they stand in for, rewrite it instead
+    std::uint8_t channels = savedChannels(voxels);
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    std::size_t bytes = sizeof(std::uint16_t) + bricks.count() * brickRecordBytes(channels);
+    if (error || size - baseBytes + bytes > baseBytes) return false;
+
+    std::vector<char> records;
+    records.reserve(bytes);
+    auto append = [&](const auto& value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        records.insert(records.end(), bytes, bytes + sizeof(value));
+    };
+    append(std::uint16_t(bricks.count()));
+    for (int brick = 0; brick < int(bricks.size()); ++brick) {
+        if (!bricks[brick]) continue;
+        append(std::uint16_t(brick));
+        append(channels);
+        forEachBrickVoxel(brick, [&](int x, int y, int z) { append(voxels.getVoxel(x, y, z).material); });
+        if (channels & SAVED_LIGHT)
+            forEachBrickVoxel(brick, [&](int x, int y, int z) { append(voxels.getLight(x, y, z)); });
+        if (channels & SAVED_DAMAGE)
+            forEachBrickVoxel(brick, [&](int x, int y, int z) { append(voxels.getDamage(x, y, z)); });
+    }
+
+    file.seekp(0, std::ios::end);
+    if (file.write(records.data(), std::streamsize(records.size())) && file.flush()) return true;
+    // A torn save would be read as the start of the next one; cut it off
+    file.close();
+    std::filesystem::resize_file(path, size, error);
+    return false;
+}
+
+bool ChunkStore::load(const glm::ivec3& chunkPos, VoxelChunk& chunk) const {
+    std::ifstream in(pathFor(chunkPos), std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    std::uint32_t baseBytes = 0;
+    if (!in.read(magic, sizeof(magic))) return false;
+    bool hasBricks = std::equal(magic, magic + sizeof(magic), MAGIC);
+    if (!hasBricks && !std::equal(magic, magic + sizeof(magic), MAGIC_V1)) return false;
+    if (hasBricks && !in.read(reinterpret_cast<char*>(&baseBytes), sizeof(baseBytes))) return false;
+
+    // Read everything before touching the chunk, so a truncated file leaves it as it was
+    std::vector<std::vector<VoxelRun>> columns(CHUNK_SIZE * CHUNK_SIZE);
+    for (std::vector<VoxelRun>& column : columns) {
+        std::uint8_t count = 0;
+        if (!in.read(reinterpret_cast<char*>(&count), 1) || count > CHUNK_SIZE) return false;
+        for (int i = 0; i < count; ++i) {
+            SavedRun run{};
+            in.read(reinterpret_cast<char*>(&run.material), sizeof(run.material));
+            in.read(reinterpret_cast<char*>(&run.length), sizeof(run.length));
+            if (!in) return false;
+            column.push_back({ run.material, run.length });
+        }
+    }
+
+    std::vector<LightLevel> light;
+    std::vector<DamageLevel> damage;
+    std::uint8_t channels = 0;
+    if (in.read(reinterpret_cast<char*>(&channels), 1)) {
+        if ((channels & SAVED_LIGHT) && !readChannel(in, light)) return false;
+        if ((channels & SAVED_DAMAGE) && !readChannel(in, damage)) return false;
+    } else if (hasBricks) {
+        return false;
+    }
+
+    struct Brick {
+        int index;
+        std::uint8_t channels;
+        MaterialId materials[BRICK_VOLUME];
+        LightLevel light[BRICK_VOLUME];
+        DamageLevel damage[BRICK_VOLUME];
+    };
+    std::vector<Brick> bricks;
+    bool torn = false;
+    if (hasBricks) {
+        if (in.tellg() != std::streampos(baseBytes)) return false;
+        std::uint16_t count = 0;
+        while (in.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+            std::size_t complete = bricks.size();
+            for (int i = 0; i < count && in; ++i) {
+                SavedBrick header{};
+                Brick& brick = bricks.emplace_back();
+                in.read(reinterpret_cast<char*>(&header.brick), sizeof(header.brick));
+                in.read(reinterpret_cast<char*>(&header.channels), sizeof(header.channels));
+                in.read(reinterpret_cast<char*>(brick.materials), sizeof(brick.materials));
+                if (in && (header.channels & SAVED_LIGHT)) in.read(reinterpret_cast<char*>(brick.light), sizeof(brick.light));
+                if (in && (header.channels & SAVED_DAMAGE)) in.read(reinterpret_cast<char*>(brick.damage), sizeof(brick.damage));
+                if (in && header.brick >= BRICKS * BRICKS * BRICKS) return false;
+                brick.index = header.brick;
+                brick.channels = header.channels;
+            }
+            // A save cut short by an interrupted append is lost whole, not brick by brick
+            if (!in) {
+                bricks.resize(complete);
+                torn = true;
+                break;
+            }
+        }
+    }
+
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+        for (int z = 0; z < CHUNK_SIZE; ++z)
+            chunk.setColumnRuns(x, z, columns[x * CHUNK_SIZE + z]);
+    // Damage after the columns, it only sticks to solid voxels
+    applyChannel(light, [&](int x, int y, int z, LightLevel level) { chunk.setLight(x, y, z, level); });
+    applyChannel(damage, [&](int x, int y, int z, DamageLevel level) { chunk.setDamage(x, y, z, level); });
+    for (const Brick& brick : bricks) {
+        int i = 0;
+        forEachBrickVoxel(brick.index, [&](int x, int y, int z) {
+            MaterialId material = brick.materials[i];
+            chunk.setVoxel(x, y, z, Voxel{ material != MATERIAL_AIR, material });
+            chunk.setLight(x, y, z, brick.channels & SAVED_LIGHT ? brick.light[i] : 0);
+            chunk.setDamage(x, y, z, brick.channels & SAVED_DAMAGE ? brick.damage[i] : 0);
+            ++i;
+        });
+    }
+    chunk.markRebuilt();
+    // Matches the file; past a torn tail appends would be misread, so the next save rewrites it
+    if (torn) chunk.markSaved();
+    else chunk.markStored();
+    chunk.publish();
+    return true;
+}
+
+bool ChunkStore::saveOverlay(const EditOverlay& overlay) const {
+    return writeFile(overlayPath(), [&](std::ofstream& out) {
+        out.write(OVERLAY_MAGIC, sizeof(OVERLAY_MAGIC));
+        std::uint32_t chunkCount = std::uint32_t(overlay.chunkCount());
+        out.write(reinterpret_cast<const char*>(&chunkCount), sizeof(chunkCount));
+        for (const auto& [key, edits] : overlay.getChunks()) {
+            SavedOverlayChunk header{ {}, std::uint16_t(edits.size()) };
+            glm::ivec3 chunkPos = mortonDecode(key);
+            for (int axis = 0; axis < 3; ++axis) header.pos[axis] = chunkPos[axis];
+            out.write(reinterpret_cast<const char*>(&header.pos), sizeof(header.pos));
+            out.write(reinterpret_cast<const char*>(&header.count), sizeof(header.count));
+            out.write(reinterpret_cast<const char*>(edits.data()), edits.size() * sizeof(EditOverlay::Edit));
+        }
+    });
+}
+
+bool ChunkStore::loadOverlay(EditOverlay& overlay) const {
+    std::ifstream in(overlayPath(), std::ios::binary);
+    char magic[sizeof(OVERLAY_MAGIC)];
+    std::uint32_t chunkCount = 0;
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), OVERLAY_MAGIC) ||
+        !in.read(reinterpret_cast<char*>(&chunkCount), sizeof(chunkCount)))
+        return false;
+
+    // Read everything first, so a truncated file leaves the overlay as it was.
+    // Counts come from the file, so nothing is sized by them up front: chunks
+    // grow as records arrive and no chunk can hold more edits than voxels.
+    // saveOverlay writes each chunk once with each index once, so a repeat
+    // means a damaged file and is rejected like one.
+    std::vector<std::pair<glm::ivec3, std::vector<EditOverlay::Edit>>> chunks;
+    MortonHashMap<bool> seen;
+    for (std::uint32_t i = 0; i < chunkCount; ++i) {
+        SavedOverlayChunk header{};
+        in.read(reinterpret_cast<char*>(&header.pos), sizeof(header.pos));
+        in.read(reinterpret_cast<char*>(&header.count), sizeof(header.count));
+        if (!in || header.count > CHUNK_VOLUME) return false;
+        glm::ivec3 chunkPos(header.pos[0], header.pos[1], header.pos[2]);
+        if (!seen.tryEmplace(chunkPos).second) return false;
+
+        std::vector<EditOverlay::Edit> edits(header.count);
+        if (!in.read(reinterpret_cast<char*>(edits.data()), edits.size() * sizeof(EditOverlay::Edit)))
+            return false;
+        std::sort(edits.begin(), edits.end(),
+                  [](const EditOverlay::Edit& a, const EditOverlay::Edit& b) { return a.index < b.index; });
+        for (std::size_t e = 0; e < edits.size(); ++e)
+            if (edits[e].index >= CHUNK_VOLUME || (e > 0 && edits[e].index == edits[e - 1].index)) return false;
+        chunks.emplace_back(chunkPos, std::move(edits));
+    }
+
+    overlay.clear();
+    for (auto& [chunkPos, edits] : chunks) overlay.assign(chunkPos, std::move(edits));
+    return true;
+}
@@ -0,0 +1,51 @@
+// chunk_store.h
+#pragma once
+
+#include <filesystem>
+#include <glm/glm.hpp>
+#include "chunk_voxels.h"
+#include "edit_overlay.h"
+
+class VoxelChunk;
+
+// Saves edited chunks as one small file per chunk coordinate, each column
+// stored as bottom-up material runs, followed by any allocated attribute
+// channels. Later saves of a chunk whose file is current append just the 4^3
+// bricks changed since (see VoxelChunk::unsavedBricks), until those records
+// outgrow a full save and the file is rewritten. Generated chunks that were
+// never edited are not saved; they are regenerated from the terrain settings
+// instead. A world keeping its edits in an EditOverlay saves that instead, as
+// one small file for the whole world.
+class ChunkStore {
+public:
+    using BrickMask = BrickVersions<CHUNK_SIZE>::Mask;
+
+    explicit ChunkStore(std::filesystem::path directory);
+
+    // Writes to a temporary file first, so a failed save never clobbers the previous one
+    bool save(const glm::ivec3& chunkPos, const ChunkVoxels& voxels) const;
+    // Appends the given bricks to the file save() last wrote for chunkPos, which
+    // must hold the contents as they were before those bricks changed (see
+    // VoxelChunk::isStored). False, leaving the file as it was, if there is no
+    // such file or it is due for a rewrite: then save() the chunk whole.
+    bool saveBricks(const glm::ivec3& chunkPos, const ChunkVoxels& voxels, const BrickMask& bricks) const;
+    // Replaces the chunk's contents with the saved ones and publishes them;
+    // false if nothing was saved for chunkPos or the file is unreadable
+    bool load(const glm::ivec3& chunkPos, VoxelChunk& chunk) const;
+    bool contains(const glm::ivec3& chunkPos) const;
+
+    // The whole overlay, written through a temporary file like save
+    bool saveOverlay(const EditOverlay& overlay) const;
+    // Replaces the overlay with the saved one; false (and the overlay untouched)
+    // if none was saved or the file is unreadable
+    bool loadOverlay(EditOverlay& overlay) const;
+
+private:
+    std::filesystem::path directory;
+
+    std::filesystem::path pathFor(const glm::ivec3& chunkPos) const;
+    std::filesystem::path overlayPath() const { return directory / "world.edits"; }
+    // Writes through path + ".tmp", renamed over path once complete
+    template <typename Write>
+    bool writeFile(const std::filesystem::path& path, Write write) const;
+};
@@ -0,0 +1,322 @@
+// chunk_voxels.cpp
+#include "chunk_voxels.h"
+
+#include <algorithm>
+#include <bit>
+
+template <int Size>
+BasicChunkVoxels<Size>::BasicChunkVoxels(const BasicChunkVoxels& other)
+    : occupancy(other.occupancy), materials(other.materials),
+      columns(other.columns ? std::make_unique<ColumnRuns>(*other.columns) : nullptr),
+      light(other.light), damage(other.damage), summary(other.summary), versions(other.versions) {
+}
+
+template <int Size>
+ChunkStorage BasicChunkVoxels<Size>::getStorage() const {
+    if (columns) return ChunkStorage::Columns;
+    return occupancy.empty() ? ChunkStorage::Uniform : ChunkStorage::Dense;
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::fill(const Voxel& voxel) {
+    MaterialId material = voxel.active ? voxel.material : MaterialId(MATERIAL_AIR);
+    materials.fill(material);
+    damage.fill(0);
+    summary.fill(material != MATERIAL_AIR);
+    versions.markAll();
+    occupancy.clear();
+    occupancy.shrink_to_fit();
+    columns.reset();
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::expand() {
+    Row row = materials.get(0) != MATERIAL_AIR ? FULL_ROW : 0;
+    occupancy.assign(Dims::AREA, row);
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::collapseIfUniform() {
+    // The palette narrows to zero bits once a single material is left
+    if (materials.bitsPerEntry() == 0) {
+        occupancy.clear();
+        occupancy.shrink_to_fit();
+    }
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::expandColumns() {
+    std::unique_ptr<ColumnRuns> runs = std::move(columns);
+    materials.fill(MATERIAL_AIR);
+    occupancy.assign(Dims::AREA, 0);
+
+    std::vector<VoxelRun> column;
+    for (int x = 0; x < Size; ++x) {
+        for (int z = 0; z < Size; ++z) {
+            runs->getColumn(x * Size + z, column);
+            int y = 0;
+            for (const VoxelRun& run : column) {
+                for (int i = 0; i < run.length; ++i, ++y) {
+                    if (run.material == MATERIAL_AIR) continue;
+                    materials.set(voxelIndex<Size>(x, y, z), run.material);
+                    occupancy[x * Size + y] |= Row(Row(1) << z);
+                }
+            }
+        }
+    }
+    collapseIfUniform();
+}
+
+template <int Size>
+bool BasicChunkVoxels<Size>::compactColumns() {
+    if (columns) return true;
+
+    auto runs = std::make_unique<ColumnRuns>(Dims::AREA, Size);
+    std::vector<VoxelRun> column;
+    for (int x = 0; x < Size; ++x) {
+        for (int z = 0; z < Size; ++z) {
+            column.clear();
+            for (int y = 0; y < Size; ++y) {
+                MaterialId material = getVoxel(x, y, z).material;
+                if (!column.empty() && column.back().material == material) ++column.back().length;
+                else column.push_back({ material, 1 });
+            }
+            if (!runs->setColumn(x * Size + z, column)) return false;
+        }
+    }
+
+    columns = std::move(runs);
+    materials.fill(MATERIAL_AIR);
+    occupancy.clear();
+    occupancy.shrink_to_fit();
+    return true;
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::setColumnRuns(int x, int z, std::span<const VoxelRun> runs) {
+    if (!contains(x, 0, z))
+        return;
+
+    if (columns) {
+        std::vector<VoxelRun> column;
+        columns->getColumn(x * Size + z, column);
+        if (columns->setColumn(x * Size + z, runs)) {
+            addToSummary(x, z, column, -1);
+            columns->getColumn(x * Size + z, column);
+            addToSummary(x, z, column, 1);
+            // The whole column was replaced; clear its damage as setVoxel does
+            for (int y = 0; y < Size; ++y)
+                damage.set(voxelIndex<Size>(x, y, z), 0);
+            versions.markColumn(x, z, 0, Size);
+            return;
+        }
+        expandColumns(); // Too many materials for the run palette
+    }
+
+    int y = 0;
+    for (const VoxelRun& run : runs)
+        for (int i = 0; i < run.length && y < Size; ++i)
+            setVoxel(x, y++, z, Voxel{ run.material != MATERIAL_AIR, run.material });
+    for (; y < Size; ++y)
+        setVoxel(x, y, z, Voxel{ false });
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::addToSummary(int x, int z, const std::vector<VoxelRun>& column, int delta) {
+    int y = 0;
+    for (const VoxelRun& run : column) {
+        if (run.material != MATERIAL_AIR) summary.addColumn(x, z, y, y + run.length, delta);
+        y += run.length;
+    }
+}
+
+template <int Size>
+auto BasicChunkVoxels<Size>::occupancyRows(std::vector<Row>& scratch) const -> const Row* {
+    if (isUniform()) return nullptr;
+    if (!columns) return occupancy.data();
+
+    scratch.assign(Dims::AREA, 0);
+    for (int x = 0; x < Size; ++x)
+        for (int z = 0; z < Size; ++z)
+            for (int y = 0; y < Size; ++y)
+                if (columns->get(x * Size + z, y) != MATERIAL_AIR)
+                    scratch[x * Size + y] |= Row(Row(1) << z);
+    return scratch.data();
+}
+
+template <int Size>
+auto BasicChunkVoxels<Size>::occupancyRow(int x, int y) const -> Row {
+    if (!occupancy.empty()) return occupancy[x * Size + y];
+    if (!columns) return materials.get(0) != MATERIAL_AIR ? FULL_ROW : 0;
+
+    Row row = 0;
+    for (int z = 0; z < Size; ++z)
+        if (columns->get(x * Size + z, y) != MATERIAL_AIR)
+            row |= Row(Row(1) << z);
+    return row;
+}
+
+template <int Size>
+void BasicChunkVoxels<Size>::materialLayers(int bx, int by, const Row (&select)[BRICK][BRICK],
+                                            std::vector<MaterialLayer>& out) const {
+    out.clear();
+    int x0 = bx * BRICK, y0 = by * BRICK;
+    // Neighbouring voxels mostly share a material, so the last layer is tried first
+    std::size_t last = 0;
+    auto add = [&](MaterialId material, int dx, int dy, Row bits) {
+        if (material == MATERIAL_AIR || !bits) return;
+        if (last >= out.size() || out[last].material != material) {
+            last = 0;
+            while (last < out.size() && out[last].material != material) ++last;
+            if (last == out.size()) out.push_back(MaterialLayer{ material, {} });
+        }
+        out[last].rows[dx][dy] |= bits;
+    };
+
+    if (columns) {
+        // One (x, z) column's runs cover all four rows of the brick column it crosses
+        static thread_local std::vector<VoxelRun> runs;
+        for (int dx = 0; dx < BRICK; ++dx) {
+            Row wanted = 0;
+            for (int dy = 0; dy < BRICK; ++dy) wanted |= select[dx][dy];
+            for (; wanted; wanted &= wanted - 1) {
+                int z = std::countr_zero(wanted);
+                Row bit = Row(Row(1) << z);
+                columns->getColumn((x0 + dx) * Size + z, runs);
+                int y = 0;
+                for (const VoxelRun& run : runs) {
+                    int end = y + run.length;
+                    for (int yy = std::max(y, y0); yy < std::min(end, y0 + BRICK); ++yy)
+                        add(run.material, dx, yy - y0, Row(select[dx][yy - y0] & bit));
+                    if (end >= y0 + BRICK) break;
+                    y = end;
+                }
+            }
+        }
+    } else if (isUniform()) {
+        for (int dx = 0; dx < BRICK; ++dx)
+            for (int dy = 0; dy < BRICK; ++dy)
+                add(materials.get(0), dx, dy, select[dx][dy]);
+    } else {
+#ifdef MAGMA_MORTON_CHUNK_LAYOUT
+        // A row's entries are spread through the Z-order, so they are read one at a time
+        for (int dx = 0; dx < BRICK; ++dx) {
+            for (int dy = 0; dy < BRICK; ++dy) {
+                for (Row wanted = select[dx][dy]; wanted; wanted &= wanted - 1) {
+                    int z = std::countr_zero(wanted);
+                    add(materials.get(voxelIndex<Size>(x0 + dx, y0 + dy, z)), dx, dy, Row(Row(1) << z));
+                }
+            }
+        }
+#else
+        // The brick column's rows at one x are adjacent entries, so each material
+        // present is matched against whole palette words, up to 64 entries (four
+        // rows of a 16^3 chunk) at a time
+        constexpr int ROWS = Size < 64 ? 64 / Size : 1;
+        static_assert(BRICK % ROWS == 0);
+        for (int dx = 0; dx < BRICK; ++dx) {
+            for (int dy = 0; dy < BRICK; dy += ROWS) {
+                std::uint64_t wanted = 0;
+                for (int r = 0; r < ROWS; ++r) wanted |= std::uint64_t(select[dx][dy + r]) << (r * Size);
+                std::size_t first = std::size_t(voxelIndex<Size>(x0 + dx, y0 + dy, 0));
+                while (wanted) {
+                    std::uint32_t slot = materials.slotAt(first + std::size_t(std::countr_zero(wanted)));
+                    std::uint64_t same = materials.slotMask(first, ROWS * Size, slot) & wanted;
+                    MaterialId material = materials.slotMaterial(slot);
+                    for (int r = 0; r < ROWS; ++r) add(material, dx, dy + r, Row(same >> (r * Size)));
+                    wanted &= ~same;
+                }
+            }
+        }
+#endif
+    }
+    // The same voxels give the same layers in any storage, and so the same quads
+    std::sort(out.begin(), out.end(), [](const MaterialLayer& a, const MaterialLayer& b) {
+        return a.material < b.material;
+    });
+}
+
+template <int Size>
+bool BasicChunkVoxels<Size>::isVoxelSolid(int x, int y, int z) const {
+    if (!contains(x, y, z))
+        return false;
+    if (columns)
+        return columns->get(x * Size + z, y) != MATERIAL_AIR;
+    if (isUniform())
+        return materials.get(0) != MATERIAL_AIR;
+    return (occupancy[x * Size + y] >> z) & 1;
+}
+
+template <int Size>
+Voxel BasicChunkVoxels<Size>::getVoxel(int x, int y, int z) const {
+    if (!contains(x, y, z))
+        return Voxel{ false, MATERIAL_AIR };
+
+    MaterialId material = columns ? columns->get(x * Size + z, y)
+                                  : materials.get(voxelIndex<Size>(x, y, z));
+    return Voxel{ material != MATERIAL_AIR, material };
+}
+
+template <int Size>
+bool BasicChunkVoxels<Size>::setVoxel(int x, int y, int z, const Voxel& voxel) {
+    if (!contains(x, y, z))
+        return false;
+
+    MaterialId material = voxel.active ? voxel.material : MaterialId(MATERIAL_AIR);
+    MaterialId previous = getVoxel(x, y, z).material;
+    if (previous == material) return false;
+
+    // Edits go to dense storage; cold column runs are unpacked first
+    if (columns) expandColumns();
+    if (isUniform()) expand();
+
+    int index = voxelIndex<Size>(x, y, z);
+    materials.set(index, material);
+    damage.set(index, 0);
+
+    Row bit = Row(Row(1) << z);
+    Row& row = occupancy[x * Size + y];
+    row = material != MATERIAL_AIR ? Row(row | bit) : Row(row & ~bit);
+    if ((previous == MATERIAL_AIR) != (material == MATERIAL_AIR))
+        summary.add(x, y, z, material != MATERIAL_AIR ? 1 : -1);
+    versions.mark(x, y, z);
+    collapseIfUniform();
+    return true;
+}
+
+template <int Size>
+LightLevel BasicChunkVoxels<Size>::getLight(int x, int y, int z) const {
+    return contains(x, y, z) ? light.get(voxelIndex<Size>(x, y, z)) : 0;
+}
+
+template <int Size>
+bool BasicChunkVoxels<Size>::setLight(int x, int y, int z, LightLevel level) {
+    if (!contains(x, y, z) || !light.set(voxelIndex<Size>(x, y, z), level)) return false;
+    versions.mark(x, y, z);
+    return true;
+}
+
+template <int Size>
+DamageLevel BasicChunkVoxels<Size>::getDamage(int x, int y, int z) const {
+    return contains(x, y, z) ? damage.get(voxelIndex<Size>(x, y, z)) : 0;
+}
+
+template <int Size>
+bool BasicChunkVoxels<Size>::setDamage(int x, int y, int z, DamageLevel level) {
+    // Only solid voxels carry damage
+    if (!isVoxelSolid(x, y, z) || !damage.set(voxelIndex<Size>(x, y, z), level)) return false;
+    versions.mark(x, y, z);
+    return true;
+}
+
+template <int Size>
+std::size_t BasicChunkVoxels<Size>::memoryUsage() const {
+    return sizeof(BasicChunkVoxels) + occupancy.capacity() * sizeof(Row) +
+           materials.memoryUsage() + (columns ? sizeof(ColumnRuns) + columns->memoryUsage() : 0) +
+           light.memoryUsage() + damage.memoryUsage() + versions.memoryUsage();
+}
+
+// The sizes the chunk templates are built for (see ChunkDims)
+template class BasicChunkVoxels<16>;
+template class BasicChunkVoxels<32>;
+template class BasicChunkVoxels<64>;
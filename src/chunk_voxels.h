@@ -0,0 +1,165 @@
+// chunk_voxels.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "voxel.h"
+#include "palette_storage.h"
+#include "voxel_channel.h"
+#include "occupancy_summary.h"
+#include "brick_versions.h"
+#include "column_runs.h"
+#include "voxel_utils.h"
+
+constexpr int CHUNK_VOLUME = ChunkDims<CHUNK_SIZE>::VOLUME;
+
+enum class FaceDirection {
+    Right = 0,
+    Left,
+    Top,
+    Bottom,
+    Front,
+    Back
+};
+
+// Per-voxel data (palette indices) is laid out row-major by default, or in
+// Z-order with MAGMA_MORTON_CHUNK_LAYOUT so that small cubic neighbourhoods
+// share cache lines. stepIndex moves one voxel along a face direction in either
+// layout; the caller keeps the step inside the chunk.
+#ifdef MAGMA_MORTON_CHUNK_LAYOUT
+template <int Size = CHUNK_SIZE>
+int voxelIndex(int x, int y, int z) {
+    return int(mortonSpread(x) << 2 | mortonSpread(y) << 1 | mortonSpread(z));
+}
+
+template <int Size = CHUNK_SIZE>
+int stepIndex(int index, FaceDirection dir) {
+    constexpr int axisMask[3] = {
+        int(mortonSpread(Size - 1) << 2),
+        int(mortonSpread(Size - 1) << 1),
+        int(mortonSpread(Size - 1))
+    };
+    int mask = axisMask[int(dir) / 2];
+    int low = mask & -mask;
+    // Fill the other axes' bits with ones so the carry ripples through this axis only
+    int axis = int(dir) % 2 == 0 ? ((index | ~mask) + low) & mask
+                                 : ((index & mask) - low) & mask;
+    return axis | (index & ~mask);
+}
+#else
+template <int Size = CHUNK_SIZE>
+int voxelIndex(int x, int y, int z) {
+    constexpr int shift = ChunkDims<Size>::SHIFT;
+    return (x << shift | y) << shift | z;
+}
+
+template <int Size = CHUNK_SIZE>
+int stepIndex(int index, FaceDirection dir) {
+    constexpr int stride[3] = { Size * Size, Size, 1 };
+    int step = stride[int(dir) / 2];
+    return int(dir) % 2 == 0 ? index + step : index - step;
+}
+#endif
+
+// One occupancy bit per voxel; a row along z is a single word (bit z = voxel z)
+template <int Size>
+using OccupancyRowFor = std::conditional_t<Size <= 8, std::uint8_t,
+                        std::conditional_t<Size <= 16, std::uint16_t,
+                        std::conditional_t<Size <= 32, std::uint32_t, std::uint64_t>>>;
+using OccupancyRow = OccupancyRowFor<CHUNK_SIZE>;
+// Rows are exactly Size bits wide, so a full row is all ones
+constexpr OccupancyRow FULL_ROW = OccupancyRow(~OccupancyRow(0));
+
+enum class ChunkStorage {
+    Uniform, // One material, no per-voxel data
+    Dense,   // Palette-packed materials plus occupancy rows
+    Columns  // Run-length encoded (x,z) columns, for cold generated terrain
+};
+
+// The voxel contents of one Size^3 chunk, without any render state. Copyable so
+// that VoxelChunk can clone it for copy-on-write edits. Instantiated for edges
+// of 16, 32 and 64 in chunk_voxels.cpp; the world uses ChunkVoxels (CHUNK_SIZE).
+template <int Size>
+class BasicChunkVoxels {
+public:
+    using Dims = ChunkDims<Size>;
+    using Row = OccupancyRowFor<Size>;
+    static constexpr Row FULL_ROW = Row(~Row(0));
+
+    BasicChunkVoxels() = default;
+    BasicChunkVoxels(const BasicChunkVoxels& other);
+    BasicChunkVoxels& operator=(const BasicChunkVoxels&) = delete;
+
+    static bool contains(int x, int y, int z) {
+        return x >= 0 && x < Size && y >= 0 && y < Size && z >= 0 && z < Size;
+    }
+
+    Voxel getVoxel(int x, int y, int z) const;
+    // Returns false if the voxel already held that value
+    bool setVoxel(int x, int y, int z, const Voxel& voxel);
+    bool isVoxelSolid(int x, int y, int z) const;
+    void fill(const Voxel& voxel);
+    // Attribute channels; out-of-range reads return 0 and setters return false if
+    // nothing changed. Damage can only be set on solid voxels.
+    LightLevel getLight(int x, int y, int z) const;
+    bool setLight(int x, int y, int z, LightLevel level);
+    DamageLevel getDamage(int x, int y, int z) const;
+    bool setDamage(int x, int y, int z, DamageLevel level);
+    // Bulk path for generators: replaces column (x,z) bottom-up, air above the last run
+    void setColumnRuns(int x, int z, std::span<const VoxelRun> runs);
+    // Re-encodes the chunk as column runs; false if it has too many materials for that
+    bool compactColumns();
+    // Counts every brick as changed, for contents just rebuilt whole; drops the per-brick stamps
+    void markRebuilt() { versions.markAll(); }
+
+    // Occupancy rows [x * Size + y] for the mesher. Column storage unpacks into
+    // scratch; uniform chunks have no rows and return nullptr.
+    const Row* occupancyRows(std::vector<Row>& scratch) const;
+    // Row (x, y) alone, in any storage; for reading a neighbour's border
+    Row occupancyRow(int x, int y) const;
+    // The selected voxels of the brick column (bx, by) split by material, for
+    // the greedy mesher: bit z of rows[dx][dy] in a material's layer is set where
+    // select has it and voxel (bx * BRICK + dx, by * BRICK + dy, z) holds that
+    // material. Air is left out, layers come in material order. Reads palette
+    // words and column runs in bulk.
+    static constexpr int BRICK = BrickVersions<Size>::BRICK;
+    struct MaterialLayer {
+        MaterialId material;
+        Row rows[BRICK][BRICK];
+    };
+    void materialLayers(int bx, int by, const Row (&select)[BRICK][BRICK], std::vector<MaterialLayer>& out) const;
+
+    const PaletteStorage& getMaterials() const { return materials; }
+    const OccupancySummary<Size>& getSummary() const { return summary; }
+    // Which bricks each edit touched, materials and attributes alike; travels
+    // with snapshots, so readers on other threads can diff against what they saw
+    const BrickVersions<Size>& getVersions() const { return versions; }
+    const VoxelChannel<LightLevel>& getLightChannel() const { return light; }
+    const VoxelChannel<DamageLevel>& getDamageChannel() const { return damage; }
+    // Uniform chunks hold one material and no per-voxel data; the first differing edit expands them
+    bool isUniform() const { return occupancy.empty() && !columns; }
+    ChunkStorage getStorage() const;
+    std::size_t memoryUsage() const;
+
+private:
+    std::vector<Row> occupancy;                 // [x * Size + y], bit z; empty while uniform
+    PaletteStorage materials{ Dims::VOLUME };   // Source of truth, occupancy mirrors it
+    std::unique_ptr<ColumnRuns> columns;        // Replaces both of the above in Columns storage
+    // Separate arrays in voxelIndex order, allocated on first write. Damage is
+    // cleared wherever the material changes; light is left to the lighting pass.
+    VoxelChannel<LightLevel> light{ Dims::VOLUME };
+    VoxelChannel<DamageLevel> damage{ Dims::VOLUME };
+    OccupancySummary<Size> summary; // Follows occupancy in every storage mode
+    BrickVersions<Size> versions;   // Stamped by every change that is not a re-encoding
+
+    void expand();
+    void expandColumns();
+    void addToSummary(int x, int z, const std::vector<VoxelRun>& column, int delta);
+    void collapseIfUniform();
+};
+
+using ChunkVoxels = BasicChunkVoxels<CHUNK_SIZE>;
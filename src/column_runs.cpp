@@ -0,0 +1,122 @@
+// column_runs.cpp
+#include "column_runs.h"
+
+#include <algorithm>
+#include <array>
+
+ColumnRuns::ColumnRuns(int columnCount, int height) : height(height), blockShift(0) {
+    // A column packs at most height runs, so a block's last column starts at
+    // most (columns - 1) * height runs after the block does
+    while (((2 << blockShift) - 1) * height <= UINT8_MAX) ++blockShift;
+    blockStart.assign((columnCount >> blockShift) + 1, 0);
+    columnOffset.assign(columnCount + 1, 0);
+}
+
+MaterialId ColumnRuns::get(int column, int y) const {
+    int top = 0;
+    for (int i = columnStart(column), end = columnStart(column + 1); i < end; ++i) {
+        top += (runs[i] & 0x0F) + 1;
+        if (y < top) return palette[runs[i] >> 4];
+    }
+    return MATERIAL_AIR;
+}
+
+bool ColumnRuns::setColumn(int column, std::span<const VoxelRun> input) {
+    // Merge neighbouring runs of the same material and clip to the column height
+    std::vector<VoxelRun> merged;
+    int total = 0;
+    for (const VoxelRun& run : input) {
+        int length = std::min(run.length, height - total);
+        if (length <= 0) continue;
+        total += length;
+        if (!merged.empty() && merged.back().material == run.material)
+            merged.back().length += length;
+        else
+            merged.push_back({ run.material, length });
+    }
+    while (!merged.empty() && merged.back().material == MATERIAL_AIR)
+        merged.pop_back();
+
+    // Everything that can fail is decided before the runs or palette change
+    int packedCount = 0;
+    for (const VoxelRun& run : merged) packedCount += (run.length + 15) / 16;
+    int begin = columnStart(column), end = columnStart(column + 1);
+    int delta = packedCount - (end - begin);
+    if (runs.size() + delta > UINT16_MAX) return false; // Block starts are 16-bit
+
+    std::vector<MaterialId> newPalette;
+    std::vector<std::uint8_t> remap;
+    if (!assignSlots(column, merged, newPalette, remap)) return false;
+
+    std::vector<std::uint8_t> packed;
+    packed.reserve(packedCount);
+    for (const VoxelRun& run : merged) {
+        int slot = int(std::find(newPalette.begin(), newPalette.end(), run.material) - newPalette.begin());
+        for (int left = run.length; left > 0; left -= 16)
+            packed.push_back(std::uint8_t(slot << 4 | (std::min(left, 16) - 1)));
+    }
+
+    if (!remap.empty())
+        for (std::uint8_t& run : runs)
+            run = std::uint8_t(remap[run >> 4] << 4 | (run & 0x0F));
+    palette = std::move(newPalette);
+
+    // Splice the new runs in and shift the starts of every later column
+    auto at = runs.erase(runs.begin() + begin, runs.begin() + end);
+    runs.insert(at, packed.begin(), packed.end());
+    int block = column >> blockShift;
+    for (int i = column + 1; i < ((block + 1) << blockShift); ++i)
+        columnOffset[i] = std::uint8_t(columnOffset[i] + delta);
+    for (std::size_t i = block + 1; i < blockStart.size(); ++i)
+        blockStart[i] = std::uint16_t(blockStart[i] + delta);
+    return true;
+}
+
+bool ColumnRuns::assignSlots(int column, const std::vector<VoxelRun>& merged, std::vector<MaterialId>& newPalette,
+                             std::vector<std::uint8_t>& remap) const {
+    auto addMaterials = [&] {
+        for (const VoxelRun& run : merged) {
+            if (std::find(newPalette.begin(), newPalette.end(), run.material) != newPalette.end()) continue;
+            if (int(newPalette.size()) == MAX_MATERIALS) return false;
+            newPalette.push_back(run.material);
+        }
+        return true;
+    };
+
+    newPalette = palette;
+    if (addMaterials()) return true;
+
+    // The column being replaced doesn't count: its runs are about to go
+    std::array<bool, MAX_MATERIALS> used{};
+    int begin = columnStart(column), end = columnStart(column + 1);
+    for (int i = 0; i < int(runs.size()); ++i)
+        if (i < begin || i >= end) used[runs[i] >> 4] = true;
+
+    newPalette.clear();
+    remap.assign(palette.size(), 0);
+    for (std::size_t slot = 0; slot < palette.size(); ++slot) {
+        if (!used[slot]) continue;
+        remap[slot] = std::uint8_t(newPalette.size());
+        newPalette.push_back(palette[slot]);
+    }
+    return addMaterials();
+}
+
+void ColumnRuns::getColumn(int column, std::vector<VoxelRun>& out) const {
+    out.clear();
+    for (int i = columnStart(column), end = columnStart(column + 1); i < end; ++i) {
+        MaterialId material = palette[runs[i] >> 4];
+        int length = (runs[i] & 0x0F) + 1;
+        if (!out.empty() && out.back().material == material)
+            out.back().length += length;
+        else
+            out.push_back({ material, length });
+    }
+}
+
+std::size_t ColumnRuns::memoryUsage() const {
+    return blockStart.capacity() * sizeof(std::uint16_t) +
+           columnOffset.capacity() * sizeof(std::uint8_t) +
+           runs.capacity() * sizeof(std::uint8_t) +
+           palette.capacity() * sizeof(MaterialId);
+}
@@ -0,0 +1,55 @@
+// column_runs.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "voxel.h"
+
+// A vertical run of one material, as emitted by generators (bottom to top)
+struct VoxelRun {
+    MaterialId material;
+    int length;
+};
+
+// Run-length encoded voxel columns. Each run is packed into one byte: a 4-bit
+// slot into a small material palette and a 4-bit length (runs longer than 16
+// are split). Air above a column's last run is implicit, so an untouched
+// terrain column costs about one byte of index plus one byte per material band.
+// The index is a byte offset per column relative to a 16-bit start per block of
+// columns, with blocks small enough that no offset passes 255.
+class ColumnRuns {
+public:
+    static constexpr int MAX_MATERIALS = 16;
+
+    ColumnRuns(int columnCount, int height);
+
+    MaterialId get(int column, int y) const;
+    // Replaces a column; returns false if it would need more than MAX_MATERIALS
+    // materials or push the chunk past 64K packed runs
+    bool setColumn(int column, std::span<const VoxelRun> runs);
+    // Unpacks a column back into runs (trailing air omitted)
+    void getColumn(int column, std::vector<VoxelRun>& out) const;
+
+    int getHeight() const { return height; }
+    std::size_t memoryUsage() const;
+
+private:
+    int height;
+    int blockShift;                          // Columns per block = 1 << blockShift
+    std::vector<std::uint16_t> blockStart;   // Per block (+ end), first run in runs
+    std::vector<std::uint8_t> columnOffset;  // Per column (+ end), first run after its block's
+    std::vector<std::uint8_t> runs;          // slot << 4 | (length - 1)
+    std::vector<MaterialId> palette;
+
+    int columnStart(int column) const {
+        return blockStart[column >> blockShift] + columnOffset[column];
+    }
+    // Builds the palette a new column would be packed against: the current one
+    // plus merged's new materials. Slots are never freed as columns change, so a
+    // full palette is first rebuilt from the slots other columns still use, with
+    // remap taking old slots to new. False if the materials still don't fit.
+    bool assignSlots(int column, const std::vector<VoxelRun>& merged, std::vector<MaterialId>& newPalette,
+                     std::vector<std::uint8_t>& remap) const;
+};
@@ -0,0 +1,64 @@
+// edit_overlay.cpp
+#include "edit_overlay.h"
+#include "voxel_chunk.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr int SHIFT = ChunkDims<CHUNK_SIZE>::SHIFT;
+    constexpr int MASK = ChunkDims<CHUNK_SIZE>::MASK;
+}
+
+void EditOverlay::set(const glm::ivec3& worldPos, MaterialId material) {
+    glm::ivec3 local = toLocalPos(worldPos);
+    std::uint16_t index = std::uint16_t((local.x << SHIFT | local.y) << SHIFT | local.z);
+
+    std::vector<Edit>& list = chunks[toChunkPos(worldPos)];
+    auto it = std::lower_bound(list.begin(), list.end(), index,
+                               [](const Edit& edit, std::uint16_t i) { return edit.index < i; });
+    if (it != list.end() && it->index == index) {
+        it->material = material;
+    } else {
+        list.insert(it, { index, material });
+        ++edits;
+    }
+    ++version;
+}
+
+std::span<const EditOverlay::Edit> EditOverlay::find(const glm::ivec3& chunkPos) const {
+    const std::vector<Edit>* list = chunks.find(chunkPos);
+    return list ? std::span<const Edit>(*list) : std::span<const Edit>();
+}
+
+bool EditOverlay::apply(VoxelChunk& chunk) const {
+    std::span<const Edit> list = find(chunk.getChunkPos());
+    for (const Edit& edit : list) {
+        int x = edit.index >> 2 * SHIFT, y = edit.index >> SHIFT & MASK, z = edit.index & MASK;
+        chunk.setVoxel(x, y, z, Voxel{ edit.material != MATERIAL_AIR, edit.material });
+    }
+    return !list.empty();
+}
+
+void EditOverlay::assign(const glm::ivec3& chunkPos, std::vector<Edit> list) {
+    // One edit per index, the last listed one winning, as if set in list order
+    std::stable_sort(list.begin(), list.end(), [](const Edit& a, const Edit& b) { return a.index < b.index; });
+    auto last = std::unique(list.rbegin(), list.rend(), [](const Edit& a, const Edit& b) { return a.index == b.index; });
+    list.erase(list.begin(), last.base());
+    if (const std::vector<Edit>* old = chunks.find(chunkPos)) edits -= old->size();
+    edits += list.size();
+    if (list.empty()) chunks.erase(chunkPos);
+    else chunks[chunkPos] = std::move(list);
+    ++version;
+}
+
+void EditOverlay::clear() {
+    chunks.clear();
+    edits = 0;
+    ++version;
+}
+
+std::size_t EditOverlay::memoryUsage() const {
+    std::size_t bytes = chunks.memoryUsage();
+    for (const auto& [key, list] : chunks) bytes += list.capacity() * sizeof(Edit);
+    return bytes;
+}
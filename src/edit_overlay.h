@@ -0,0 +1,51 @@
+// edit_overlay.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxel.h"
+#include "voxel_utils.h"
+#include "morton_hash_map.h"
+
+class VoxelChunk;
+
+// The world's edits as a sparse list per chunk, to be replayed on top of the
+// deterministic terrain generator. A chunk nobody edited has no entry and costs
+// nothing; an edited one costs four bytes per changed voxel, so it can be
+// dropped from memory and rebuilt by regenerating it and applying its edits.
+class EditOverlay {
+public:
+    // One changed voxel: its local index (x, y, z order) and new material
+    struct Edit {
+        std::uint16_t index;
+        MaterialId material; // MATERIAL_AIR where the voxel was removed
+    };
+    static_assert(ChunkDims<CHUNK_SIZE>::VOLUME <= 1 << 16, "local voxel index must fit 16 bits");
+
+    // Records the voxel's new material, replacing any earlier edit of it
+    void set(const glm::ivec3& worldPos, MaterialId material);
+    // Edits of one chunk sorted by index, empty if it has none
+    std::span<const Edit> find(const glm::ivec3& chunkPos) const;
+    // Writes the chunk's edits into its draft; false if it has none
+    bool apply(VoxelChunk& chunk) const;
+    // Replaces a chunk's edits wholesale, as read back from a ChunkStore; of
+    // edits repeating an index, the last one listed is kept
+    void assign(const glm::ivec3& chunkPos, std::vector<Edit> edits);
+    void clear();
+
+    // Chunks with edits, keyed by the Morton code of their position
+    const MortonHashMap<std::vector<Edit>>& getChunks() const { return chunks; }
+    std::size_t chunkCount() const { return chunks.size(); }
+    std::size_t editCount() const { return edits; }
+    std::size_t memoryUsage() const;
+    // Bumped by every change, so a saver can tell whether it is behind
+    std::uint64_t getVersion() const { return version; }
+
+private:
+    MortonHashMap<std::vector<Edit>> chunks;
+    std::size_t edits = 0;
+    std::uint64_t version = 0;
+};
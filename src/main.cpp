@@ -3,6 +3,7 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <memory>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -15,7 +16,8 @@
 #include "particle.h"
 
 Camera camera(glm::vec3(0.0f, 30.0f, 30.0f));
-VoxelWorld voxelWorld;
+// Owns chunk GL buffers, so it is created once the context exists and destroyed before it goes
+std::unique_ptr<VoxelWorld> voxelWorld;
 std::vector<Projectile> projectiles;
 
 struct GunPart {
@@ -59,6 +61,12 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
     }
 }
 
+void key_callback(GLFWwindow* /*window*/, int key, int /*scancode*/, int action, int /*mods*/) {
+    // G toggles greedy meshing
+    if (key == GLFW_KEY_G && action == GLFW_PRESS)
+        voxelWorld->meshMode = voxelWorld->meshMode == MeshMode::Greedy ? MeshMode::Faces : MeshMode::Greedy;
+}
+
 void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
@@ -91,6 +99,7 @@ int main() {
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     if (!gladLoadGL((GLADloadfunc)glfwGetProcAddress)) {
         std::cerr << "❌ Failed to initialize GLAD\n";
@@ -102,9 +111,12 @@ int main() {
     glClearColor(0.52f, 0.80f, 0.92f, 1.0f);
 
     Shader shader("shaders/cube.vert", "shaders/cube.frag");
+    // Same lighting, fed the packed chunk mesh vertices
+    Shader chunkShader("shaders/chunk.vert", "shaders/cube.frag");
     CubeRenderer cubeRenderer;
 
-    voxelWorld.generateTerrain(32, 32, 8);
+    voxelWorld = std::make_unique<VoxelWorld>();
+    voxelWorld->generateTerrain(32, 32, 8);
 
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = float(glfwGetTime());
@@ -118,26 +130,32 @@ int main() {
         glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
         glm::mat4 viewProj = projection * view;
 
-        shader.use();
-        shader.setMat4("view", glm::value_ptr(view));
-        shader.setMat4("projection", glm::value_ptr(projection));
-        shader.setVec3("lightPos", glm::vec3(10.0f, 10.0f, 10.0f));
-        shader.setVec3("viewPos", camera.position);
+        for (const Shader* s : { &chunkShader, &shader }) {
+            s->use();
+            s->setMat4("view", glm::value_ptr(view));
+            s->setMat4("projection", glm::value_ptr(projection));
+            s->setVec3("lightPos", glm::vec3(10.0f, 10.0f, 10.0f));
+            s->setVec3("viewPos", camera.position);
+        }
 
         // --- Voxels ---
-        shader.setVec3("blockColor", glm::vec3(0.2f, 0.8f, 0.2f));
-        voxelWorld.draw(cubeRenderer, shader, viewProj);
+        chunkShader.use();
+        chunkShader.setVec3("blockColor", glm::vec3(0.2f, 0.8f, 0.2f));
+        voxelWorld->draw(cubeRenderer, chunkShader, viewProj);
+        voxelWorld->trimToBudget();
+        shader.use();
 
         // --- Projectiles ---
         for (auto& p : projectiles) {
+            glm::vec3 previous = p.position;
             p.position += p.velocity * deltaTime;
             p.life -= deltaTime;
 
-            if (glm::dot(p.velocity, p.velocity) > 0.0001f) {
-                glm::ivec3 checkPos = glm::round(p.position);
-                Voxel* voxel = voxelWorld.getVoxel(checkPos);
-                if (voxel && voxel->active) {
-                    voxelWorld.deactivateVoxel(checkPos);
+            // Sweep the whole step so fast shots cannot pass through thin walls between frames
+            float step = glm::length(p.position - previous);
+            if (glm::dot(p.velocity, p.velocity) > 0.0001f && step > 0.0f) {
+                if (auto hit = voxelWorld->raycast(previous, (p.position - previous) / step, step)) {
+                    voxelWorld->deactivateVoxel(hit->voxel);
                     p.life = 0.0f;
                 }
             }
@@ -180,6 +198,7 @@ int main() {
         glfwPollEvents();
     }
 
+    voxelWorld.reset();
     glfwTerminate();
     return 0;
 }
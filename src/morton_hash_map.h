@@ -0,0 +1,151 @@
+// morton_hash_map.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxel_utils.h"
+
+// Flat open-addressing map from integer grid positions to T. Keys are 64-bit
+// Morton codes; slots are probed linearly and erased by backward shifting, so
+// there are no tombstones and no per-entry allocations. Pointers returned by
+// find/tryEmplace stay valid only until the next insertion.
+template <typename T>
+class MortonHashMap {
+public:
+    struct Slot {
+        std::uint64_t key = EMPTY;
+        T value{};
+    };
+
+    template <typename SlotT>
+    class Iterator {
+    public:
+        Iterator(SlotT* slot, SlotT* end) : slot(slot), end(end) { skipEmpty(); }
+        SlotT& operator*() const { return *slot; }
+        SlotT* operator->() const { return slot; }
+        Iterator& operator++() { ++slot; skipEmpty(); return *this; }
+        bool operator!=(const Iterator& other) const { return slot != other.slot; }
+
+    private:
+        SlotT* slot;
+        SlotT* end;
+        void skipEmpty() { while (slot != end && slot->key == EMPTY) ++slot; }
+    };
+
+    using iterator = Iterator<Slot>;
+    using const_iterator = Iterator<const Slot>;
+
+    MortonHashMap() { rehash(16); }
+
+    T* find(const glm::ivec3& pos) { return findKey(mortonEncode(pos)); }
+    const T* find(const glm::ivec3& pos) const { return const_cast<MortonHashMap*>(this)->find(pos); }
+
+    // Looks up count positions at once: hashes and prefetches every bucket before probing any
+    void findBatch(const glm::ivec3* positions, std::size_t count, T** out) {
+        constexpr std::size_t BATCH = 16;
+        std::uint64_t keys[BATCH];
+        std::size_t buckets[BATCH];
+        for (std::size_t base = 0; base < count; base += BATCH) {
+            std::size_t n = count - base < BATCH ? count - base : BATCH;
+            for (std::size_t i = 0; i < n; ++i) {
+                keys[i] = mortonEncode(positions[base + i]);
+                buckets[i] = bucketFor(keys[i]);
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(&slots[buckets[i]]);
+#endif
+            }
+            for (std::size_t i = 0; i < n; ++i)
+                out[base + i] = probe(keys[i], buckets[i]);
+        }
+    }
+
+    // Returns the value slot for pos and whether it was newly inserted
+    std::pair<T*, bool> tryEmplace(const glm::ivec3& pos) {
+        std::uint64_t key = mortonEncode(pos);
+        if (T* existing = findKey(key)) return { existing, false };
+
+        if ((count + 1) * 10 > slots.size() * 7) rehash(slots.size() * 2);
+        std::size_t i = bucketFor(key);
+        while (slots[i].key != EMPTY) i = (i + 1) & mask;
+        slots[i].key = key;
+        ++count;
+        return { &slots[i].value, true };
+    }
+
+    T& operator[](const glm::ivec3& pos) { return *tryEmplace(pos).first; }
+
+    bool erase(const glm::ivec3& pos) {
+        std::uint64_t key = mortonEncode(pos);
+        std::size_t i = bucketFor(key);
+        while (slots[i].key != key) {
+            if (slots[i].key == EMPTY) return false;
+            i = (i + 1) & mask;
+        }
+
+        // Backward-shift deletion: pull later entries of the probe run into the hole
+        for (std::size_t j = (i + 1) & mask; slots[j].key != EMPTY; j = (j + 1) & mask) {
+            std::size_t home = bucketFor(slots[j].key);
+            bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+            if (movable) {
+                slots[i] = std::move(slots[j]);
+                i = j;
+            }
+        }
+        slots[i].key = EMPTY;
+        slots[i].value = T{};
+        --count;
+        return true;
+    }
+
+    void clear() { rehash(16); count = 0; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::size_t memoryUsage() const { return slots.capacity() * sizeof(Slot); }
+
+    iterator begin() { return iterator(slots.data(), slots.data() + slots.size()); }
+    iterator end() { return iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+    const_iterator begin() const { return const_iterator(slots.data(), slots.data() + slots.size()); }
+    const_iterator end() const { return const_iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+
+private:
+    static constexpr std::uint64_t EMPTY = ~std::uint64_t(0); // Morton codes use 63 bits, never all ones
+
+    std::vector<Slot> slots;
+    std::size_t count = 0;
+    std::size_t mask = 0;
+    int shift = 0;
+
+    // Fibonacci hashing: neighbouring Morton codes differ in low bits, the multiply spreads them
+    std::size_t bucketFor(std::uint64_t key) const {
+        return std::size_t((key * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    T* probe(std::uint64_t key, std::size_t i) {
+        while (slots[i].key != EMPTY) {
+            if (slots[i].key == key) return &slots[i].value;
+            i = (i + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    T* findKey(std::uint64_t key) { return probe(key, bucketFor(key)); }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Slot> old = std::move(slots);
+        slots.clear();
+        slots.resize(capacity);
+        mask = capacity - 1;
+        shift = 64;
+        for (std::size_t c = capacity; c > 1; c >>= 1) --shift;
+
+        for (Slot& slot : old) {
+            if (slot.key == EMPTY) continue;
+            std::size_t i = bucketFor(slot.key);
+            while (slots[i].key != EMPTY) i = (i + 1) & mask;
+            slots[i] = std::move(slot);
+        }
+    }
+};
@@ -0,0 +1,59 @@
+// occupancy_summary.cpp
+#include "occupancy_summary.h"
+
+#include <algorithm>
+
+template <int Size>
+void OccupancySummary<Size>::fill(bool solid) {
+    brickSolid.fill(solid ? BRICK_VOLUME : 0);
+    std::uint64_t word = solid ? ~std::uint64_t(0) : 0;
+    brickAnyBits.fill(word);
+    brickAllBits.fill(word);
+    blockAnyBits.fill(word);
+    blockAllBits.fill(word);
+    solidCount = solid ? std::size_t(Size) * Size * Size : 0;
+}
+
+template <int Size>
+void OccupancySummary<Size>::addColumn(int x, int z, int yBegin, int yEnd, int delta) {
+    int bx = x / BRICK, bz = z / BRICK;
+    for (int y = yBegin; y < yEnd;) {
+        int by = y / BRICK;
+        int count = std::min(yEnd, (by + 1) * BRICK) - y;
+        brickSolid[brickIndex(bx, by, bz)] += std::uint8_t(delta * count);
+        solidCount += std::size_t(std::ptrdiff_t(delta) * count);
+        updateBrick(bx, by, bz);
+        y += count;
+    }
+}
+
+template <int Size>
+void OccupancySummary<Size>::updateBrick(int bx, int by, int bz) {
+    int solid = brickSolid[brickIndex(bx, by, bz)];
+    assign(brickAnyBits, brickIndex(bx, by, bz), solid != 0);
+    assign(brickAllBits, brickIndex(bx, by, bz), solid == BRICK_VOLUME);
+
+    // The block from its 2^3 bricks
+    int x0 = bx & ~1, y0 = by & ~1, z0 = bz & ~1;
+    bool any = false, all = true;
+    for (int i = 0; i < 8; ++i) {
+        int child = brickIndex(x0 + (i >> 2), y0 + (i >> 1 & 1), z0 + (i & 1));
+        any |= test(brickAnyBits, child);
+        all &= test(brickAllBits, child);
+    }
+    int block = blockIndex(bx / 2, by / 2, bz / 2);
+    assign(blockAnyBits, block, any);
+    assign(blockAllBits, block, all);
+}
+
+template <int Size>
+int OccupancySummary<Size>::emptyCell(int x, int y, int z) const {
+    if (!anySolid()) return Size;
+    if (!blockAny(x / BLOCK, y / BLOCK, z / BLOCK)) return BLOCK;
+    if (!brickAny(x / BRICK, y / BRICK, z / BRICK)) return BRICK;
+    return 0;
+}
+
+template class OccupancySummary<16>;
+template class OccupancySummary<32>;
+template class OccupancySummary<64>;
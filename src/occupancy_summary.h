@@ -0,0 +1,63 @@
+// occupancy_summary.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Coarse "any solid / all solid" masks over a Size^3 chunk at three levels:
+// 4^3-voxel bricks, 8^3-voxel blocks (2^3 bricks) and the whole chunk. Kept in
+// step with every edit from per-brick solid counts, so a column can be added or
+// removed as a y range without looking at its neighbours. Raycasts and the
+// mesher use it to step over empty (or buried) space a brick or more at a time.
+template <int Size>
+class OccupancySummary {
+public:
+    static constexpr int BRICK = 4;
+    static constexpr int BLOCK = 8;
+    static constexpr int BRICKS = Size / BRICK; // Per axis
+    static constexpr int BLOCKS = Size / BLOCK;
+    static_assert(Size % BLOCK == 0, "chunk edge must be a multiple of the block edge");
+
+    // Every voxel air, or every voxel solid
+    void fill(bool solid);
+    // delta is +1 where a voxel became solid, -1 where it became air
+    void add(int x, int y, int z, int delta) { addColumn(x, z, y, y + 1, delta); }
+    // The same for voxels [yBegin, yEnd) of column (x, z)
+    void addColumn(int x, int z, int yBegin, int yEnd, int delta);
+
+    bool anySolid() const { return solidCount != 0; }
+    bool allSolid() const { return solidCount == std::size_t(Size) * Size * Size; }
+    // Brick / block coordinates, each in [0, BRICKS) / [0, BLOCKS)
+    bool brickAny(int bx, int by, int bz) const { return test(brickAnyBits, brickIndex(bx, by, bz)); }
+    bool brickAll(int bx, int by, int bz) const { return test(brickAllBits, brickIndex(bx, by, bz)); }
+    bool blockAny(int bx, int by, int bz) const { return test(blockAnyBits, blockIndex(bx, by, bz)); }
+    bool blockAll(int bx, int by, int bz) const { return test(blockAllBits, blockIndex(bx, by, bz)); }
+
+    // Edge of the largest aligned empty cell holding voxel (x, y, z): Size, BLOCK
+    // or BRICK, or 0 if its brick has solid voxels (ask the chunk)
+    int emptyCell(int x, int y, int z) const;
+
+private:
+    static constexpr int BRICK_COUNT = BRICKS * BRICKS * BRICKS;
+    static constexpr int BLOCK_COUNT = BLOCKS * BLOCKS * BLOCKS;
+    static constexpr int BRICK_VOLUME = BRICK * BRICK * BRICK;
+    template <int Bits>
+    using BitSet = std::array<std::uint64_t, (Bits + 63) / 64>;
+
+    std::array<std::uint8_t, BRICK_COUNT> brickSolid{}; // Solid voxels per brick, 0..64
+    BitSet<BRICK_COUNT> brickAnyBits{}, brickAllBits{};
+    BitSet<BLOCK_COUNT> blockAnyBits{}, blockAllBits{};
+    std::size_t solidCount = 0;
+
+    static int brickIndex(int bx, int by, int bz) { return (bx * BRICKS + by) * BRICKS + bz; }
+    static int blockIndex(int bx, int by, int bz) { return (bx * BLOCKS + by) * BLOCKS + bz; }
+    template <std::size_t N>
+    static bool test(const std::array<std::uint64_t, N>& bits, int i) { return bits[i >> 6] >> (i & 63) & 1; }
+    template <std::size_t N>
+    static void assign(std::array<std::uint64_t, N>& bits, int i, bool value) {
+        std::uint64_t mask = std::uint64_t(1) << (i & 63);
+        bits[i >> 6] = value ? bits[i >> 6] | mask : bits[i >> 6] & ~mask;
+    }
+    void updateBrick(int bx, int by, int bz);
+};
@@ -0,0 +1,39 @@
+// padded_occupancy.cpp
+#include "padded_occupancy.h"
+
+#include <algorithm>
+
+template <int Size>
+void PaddedOccupancy<Size>::build(const Voxels& centre, const Neighbours& neighbours) {
+    rows.assign(PADDED * PADDED, 0);
+    front.assign(Size, 0);
+    back.assign(Size, 0);
+
+    const Row* centreRows = centre.occupancyRows(scratch);
+    for (int x = 0; x < Size; ++x) {
+        Row* dst = &rows[(x + 1) * PADDED + 1];
+        if (centreRows) std::copy(centreRows + x * Size, centreRows + (x + 1) * Size, dst);
+        else std::fill(dst, dst + Size, centre.occupancyRow(0, 0)); // Uniform
+    }
+
+    // The neighbour's layer that touches this chunk, one row (or bit) per voxel
+    constexpr int last = Size - 1;
+    if (const Voxels* n = neighbours[int(FaceDirection::Right)])
+        for (int y = 0; y < Size; ++y) rows[(Size + 1) * PADDED + (y + 1)] = n->occupancyRow(0, y);
+    if (const Voxels* n = neighbours[int(FaceDirection::Left)])
+        for (int y = 0; y < Size; ++y) rows[y + 1] = n->occupancyRow(last, y);
+    if (const Voxels* n = neighbours[int(FaceDirection::Top)])
+        for (int x = 0; x < Size; ++x) rows[(x + 1) * PADDED + Size + 1] = n->occupancyRow(x, 0);
+    if (const Voxels* n = neighbours[int(FaceDirection::Bottom)])
+        for (int x = 0; x < Size; ++x) rows[(x + 1) * PADDED] = n->occupancyRow(x, last);
+    if (const Voxels* n = neighbours[int(FaceDirection::Front)])
+        for (int x = 0; x < Size; ++x)
+            for (int y = 0; y < Size; ++y) front[x] |= Row(Row(n->isVoxelSolid(x, y, 0)) << y);
+    if (const Voxels* n = neighbours[int(FaceDirection::Back)])
+        for (int x = 0; x < Size; ++x)
+            for (int y = 0; y < Size; ++y) back[x] |= Row(Row(n->isVoxelSolid(x, y, last)) << y);
+}
+
+template class PaddedOccupancy<16>;
+template class PaddedOccupancy<32>;
+template class PaddedOccupancy<64>;
@@ -0,0 +1,35 @@
+// padded_occupancy.h
+#pragma once
+
+#include <array>
+#include <vector>
+#include "chunk_voxels.h"
+
+// Meshing input: a chunk's occupancy rows plus a one-voxel apron copied from
+// its six neighbours, (Size+2)^2 rows in all. The mesher can then look one
+// voxel past any edge without a bounds check, and border faces against solid
+// neighbours are culled. The z apron is kept as separate bit masks rather than
+// widening every row by two bits, so a row stays one Size-bit word.
+template <int Size>
+class PaddedOccupancy {
+public:
+    using Row = OccupancyRowFor<Size>;
+    using Voxels = BasicChunkVoxels<Size>;
+    // Indexed by FaceDirection; a missing neighbour counts as air
+    using Neighbours = std::array<const Voxels*, 6>;
+    static constexpr int PADDED = Size + 2;
+
+    void build(const Voxels& centre, const Neighbours& neighbours);
+
+    // Row along z at (x, y), each in [-1, Size]; bit z = voxel z
+    Row row(int x, int y) const { return rows[(x + 1) * PADDED + (y + 1)]; }
+    // Voxel (x, y, Size) moved to bit Size-1 and (x, y, -1) to bit 0, ready to
+    // be or'ed into a row shifted by one along z
+    Row frontApron(int x, int y) const { return Row(Row(front[x] >> y & 1) << (Size - 1)); }
+    Row backApron(int x, int y) const { return Row(back[x] >> y & 1); }
+
+private:
+    std::vector<Row> rows;        // [(x + 1) * PADDED + (y + 1)], corners unused
+    std::vector<Row> front, back; // [x], bit y: the +z / -z neighbour's facing voxel
+    std::vector<Row> scratch;     // Unpacked rows of a column-stored centre
+};
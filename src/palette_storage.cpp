@@ -0,0 +1,187 @@
+// palette_storage.cpp
+#include "palette_storage.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+    int widthFor(std::size_t entries) {
+        if (entries <= 1) return 0;
+        if (entries <= 2) return 1;
+        if (entries <= 4) return 2;
+        if (entries <= 16) return 4;
+        if (entries <= 256) return 8;
+        return 16;
+    }
+
+    // Widths are powers of two, so entries per word are too: index >> perWordShift(bits) is the word
+    int perWordShift(int bits) { return 6 - std::countr_zero(unsigned(bits)); }
+
+    std::uint32_t readPacked(const std::vector<std::uint64_t>& words, int bits, std::size_t index) {
+        int wordShift = perWordShift(bits);
+        std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+        int shift = int(index & ((std::size_t(1) << wordShift) - 1)) * bits;
+        return std::uint32_t((words[index >> wordShift] >> shift) & mask);
+    }
+
+    void writePacked(std::vector<std::uint64_t>& words, int bits, std::size_t index, std::uint32_t value) {
+        int wordShift = perWordShift(bits);
+        std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+        int shift = int(index & ((std::size_t(1) << wordShift) - 1)) * bits;
+        std::uint64_t& word = words[index >> wordShift];
+        word = (word & ~(mask << shift)) | (std::uint64_t(value) << shift);
+    }
+}
+
+PaletteStorage::PaletteStorage(std::size_t size, MaterialId initial) : count(size) {
+    fill(initial);
+}
+
+MaterialId PaletteStorage::get(std::size_t index) const {
+    return palette[readIndex(index)];
+}
+
+std::uint64_t PaletteStorage::slotMask(std::size_t first, int count, std::uint32_t slot) const {
+    auto low = [](int n) { return n == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1; };
+    if (bits == 0) return slot == 0 ? low(count) : 0;
+
+    int wordShift = perWordShift(bits), perWord = 1 << wordShift;
+    std::uint64_t mask = low(bits);
+    std::uint64_t result = 0;
+    for (int done = 0; done < count;) {
+        std::size_t index = first + std::size_t(done);
+        int offset = int(index & std::size_t(perWord - 1));
+        int take = std::min(count - done, perWord - offset);
+        std::uint64_t word = words[index >> wordShift] >> (offset * bits);
+        std::uint64_t matches = 0;
+        if (bits <= 4) {
+            // XOR with the slot repeated in every field, fold each field onto its
+            // low bit, and gather those bits together
+            std::uint64_t fields = ~std::uint64_t(0) / mask;
+            std::uint64_t x = word ^ (fields * slot);
+            for (int shift = 1; shift < bits; shift <<= 1) x |= x >> shift;
+            x = ~x & fields;
+            if (bits == 2) {
+                x = (x | x >> 1) & 0x3333333333333333;
+                x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0F;
+                x = (x | x >> 4) & 0x00FF00FF00FF00FF;
+                x = (x | x >> 8) & 0x0000FFFF0000FFFF;
+                x = (x | x >> 16) & 0x00000000FFFFFFFF;
+            } else if (bits == 4) {
+                x = (x | x >> 3) & 0x0303030303030303;
+                x = (x | x >> 6) & 0x000F000F000F000F;
+                x = (x | x >> 12) & 0x000000FF000000FF;
+                x = (x | x >> 24) & 0x000000000000FFFF;
+            }
+            matches = x;
+        } else {
+            for (int i = 0; i < take; ++i)
+                if ((word >> (i * bits) & mask) == slot) matches |= std::uint64_t(1) << i;
+        }
+        result |= (matches & low(take)) << done;
+        done += take;
+    }
+    return result;
+}
+
+void PaletteStorage::set(std::size_t index, MaterialId material) {
+    std::uint32_t current = readIndex(index);
+    if (palette[current] == material) return;
+
+    std::uint32_t slot = acquireSlot(material);
+    writeIndex(index, slot);
+    ++refCounts[slot];
+
+    if (--refCounts[current] == 0) {
+        --liveEntries;
+        shrinkToFit();
+    }
+}
+
+void PaletteStorage::fill(MaterialId material) {
+    palette.assign(1, material);
+    refCounts.assign(1, std::uint32_t(count));
+    liveEntries = 1;
+    bits = 0;
+    words.clear();
+    words.shrink_to_fit();
+}
+
+std::size_t PaletteStorage::memoryUsage() const {
+    return palette.capacity() * sizeof(MaterialId) +
+           refCounts.capacity() * sizeof(std::uint32_t) +
+           words.capacity() * sizeof(std::uint64_t);
+}
+
+std::uint32_t PaletteStorage::readIndex(std::size_t index) const {
+    if (bits == 0) return 0;
+    return readPacked(words, bits, index);
+}
+
+void PaletteStorage::writeIndex(std::size_t index, std::uint32_t slot) {
+    writePacked(words, bits, index, slot);
+}
+
+std::uint32_t PaletteStorage::acquireSlot(MaterialId material) {
+    for (std::size_t slot = 0; slot < palette.size(); ++slot)
+        if (refCounts[slot] > 0 && palette[slot] == material)
+            return std::uint32_t(slot);
+
+    ++liveEntries;
+    for (std::size_t slot = 0; slot < palette.size(); ++slot) {
+        if (refCounts[slot] == 0) {
+            palette[slot] = material;
+            return std::uint32_t(slot);
+        }
+    }
+
+    palette.push_back(material);
+    refCounts.push_back(0);
+
+    // Slot numbers survive a widen unchanged, so the remap is the identity
+    int needed = widthFor(palette.size());
+    if (needed > bits) {
+        std::vector<std::uint32_t> identity(palette.size());
+        for (std::size_t slot = 0; slot < identity.size(); ++slot)
+            identity[slot] = std::uint32_t(slot);
+        repack(needed, identity);
+    }
+    return std::uint32_t(palette.size() - 1);
+}
+
+void PaletteStorage::repack(int newBits, const std::vector<std::uint32_t>& remap) {
+    std::vector<std::uint64_t> old = std::move(words);
+    int oldBits = bits;
+
+    bits = newBits;
+    words.clear();
+    if (bits == 0) return;
+
+    std::size_t perWord = 64 / bits;
+    words.assign((count + perWord - 1) / perWord, 0);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint32_t slot = oldBits == 0 ? 0 : readPacked(old, oldBits, i);
+        writePacked(words, bits, i, remap[slot]);
+    }
+}
+
+void PaletteStorage::shrinkToFit() {
+    int needed = widthFor(liveEntries);
+    if (needed >= bits) return;
+
+    // Drop free slots and renumber the live ones densely
+    std::vector<std::uint32_t> remap(palette.size(), 0);
+    std::vector<MaterialId> livePalette;
+    std::vector<std::uint32_t> liveRefs;
+    for (std::size_t slot = 0; slot < palette.size(); ++slot) {
+        if (refCounts[slot] == 0) continue;
+        remap[slot] = std::uint32_t(livePalette.size());
+        livePalette.push_back(palette[slot]);
+        liveRefs.push_back(refCounts[slot]);
+    }
+
+    repack(needed, remap);
+    palette = std::move(livePalette);
+    refCounts = std::move(liveRefs);
+    words.shrink_to_fit();
+}
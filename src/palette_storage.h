@@ -0,0 +1,44 @@
+// palette_storage.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "voxel.h"
+
+// Fixed-size array of material ids stored as a small palette plus bit-packed
+// palette indices. Index width is 0/1/2/4/8/16 bits and follows the number of
+// distinct materials in use: it widens when a new material arrives and narrows
+// again once materials disappear. Widths divide 64, so no index straddles a word.
+class PaletteStorage {
+public:
+    explicit PaletteStorage(std::size_t size, MaterialId initial = MATERIAL_AIR);
+
+    MaterialId get(std::size_t index) const;
+    void set(std::size_t index, MaterialId material);
+    void fill(MaterialId material);
+    // Bulk reads for the mesher: bit i of slotMask is set where entry first + i
+    // (count <= 64) holds palette slot `slot`. Up to 4 bits wide, a word's
+    // entries are all compared at once.
+    std::uint64_t slotMask(std::size_t first, int count, std::uint32_t slot) const;
+    std::uint32_t slotAt(std::size_t index) const { return readIndex(index); }
+    MaterialId slotMaterial(std::uint32_t slot) const { return palette[slot]; }
+
+    int bitsPerEntry() const { return bits; }
+    std::size_t paletteSize() const { return liveEntries; }
+    std::size_t memoryUsage() const;
+
+private:
+    std::size_t count;
+    int bits = 0;                         // 0 = every entry is palette[0]
+    std::size_t liveEntries = 0;
+    std::vector<MaterialId> palette;      // Slots with a zero ref count are free
+    std::vector<std::uint32_t> refCounts;
+    std::vector<std::uint64_t> words;
+
+    std::uint32_t readIndex(std::size_t index) const;
+    void writeIndex(std::size_t index, std::uint32_t slot);
+    std::uint32_t acquireSlot(MaterialId material);
+    void repack(int newBits, const std::vector<std::uint32_t>& remap);
+    void shrinkToFit();
+};
@@ -0,0 +1,158 @@
+// sparse_voxel_dag.cpp
+#include "sparse_voxel_dag.h"
+#include "chunk_pool.h"
+
+#include <algorithm>
+
+static_assert(SparseVoxelDag::REGION_LEVELS == ChunkPool::REGION_BITS + ChunkDims<CHUNK_SIZE>::SHIFT);
+
+// The region's chunk contents by local chunk position (x, y, z order), null where it holds none
+struct SparseVoxelDag::RegionChunks {
+    std::array<const ChunkVoxels*, ChunkPool::REGION_CHUNKS> voxels{};
+
+    const ChunkVoxels* at(const glm::ivec3& local) const {
+        glm::ivec3 c = local >> ChunkDims<CHUNK_SIZE>::SHIFT;
+        return voxels[(c.x * ChunkPool::REGION_EDGE + c.y) * ChunkPool::REGION_EDGE + c.z];
+    }
+};
+
+std::size_t SparseVoxelDag::ChildrenHash::operator()(const Children& children) const {
+    std::size_t h = 0;
+    for (std::uint32_t child : children)
+        h = (h ^ child) * 0x100000001B3ull; // FNV-style mix
+    return h;
+}
+
+SparseVoxelDag::SparseVoxelDag(const SparseVoxelOctree& octree)
+    : levels(octree.levels), origin(octree.origin) {
+    // The table only lives for the build; the finished DAG keeps just the node array
+    UniqueNodes unique;
+    root = intern(octree, 0, unique);
+    nodes.shrink_to_fit();
+}
+
+SparseVoxelDag::SparseVoxelDag(const ChunkPool& pool, const glm::ivec3& regionPos)
+    : levels(REGION_LEVELS), origin(regionPos * (ChunkPool::REGION_EDGE * CHUNK_SIZE)) {
+    RegionChunks chunks;
+    pool.forEachChunkInRegion(regionPos, [&](VoxelChunk& chunk) {
+        glm::ivec3 c = chunk.getChunkPos() - regionPos * ChunkPool::REGION_EDGE;
+        chunks.voxels[(c.x * ChunkPool::REGION_EDGE + c.y) * ChunkPool::REGION_EDGE + c.z] = &chunk.voxels();
+    });
+
+    UniqueNodes unique;
+    root = intern(chunks, glm::ivec3(0), levels, unique);
+    nodes.shrink_to_fit();
+}
+
+std::uint32_t SparseVoxelDag::internChildren(const Children& children, UniqueNodes& unique) {
+    bool uniform = (children[0] & LEAF_BIT) != 0;
+    for (int i = 1; uniform && i < 8; ++i) uniform = children[i] == children[0];
+    if (uniform) return children[0];
+
+    auto [it, inserted] = unique.try_emplace(children, std::uint32_t(nodes.size()));
+    if (inserted) nodes.push_back(children);
+    return it->second;
+}
+
+std::uint32_t SparseVoxelDag::intern(const SparseVoxelOctree& octree, std::uint32_t node, UniqueNodes& unique) {
+    const SparseVoxelOctree::Node& source = octree.nodes[node];
+    if (source.firstChild == 0) return LEAF_BIT | source.material;
+
+    // Children first, so equal subtrees already share an index when we compare them
+    Children children;
+    for (int i = 0; i < 8; ++i)
+        children[i] = intern(octree, source.firstChild + i, unique);
+    return internChildren(children, unique);
+}
+
+std::uint32_t SparseVoxelDag::intern(const RegionChunks& chunks, const glm::ivec3& min, int shift,
+                                     UniqueNodes& unique) {
+    // Whole chunks that are missing or uniform end the descent early
+    if (shift <= ChunkDims<CHUNK_SIZE>::SHIFT) {
+        const ChunkVoxels* voxels = chunks.at(min);
+        if (!voxels) return LEAF_BIT | MATERIAL_AIR;
+        glm::ivec3 local = min & ChunkDims<CHUNK_SIZE>::MASK;
+        if (shift == 0 || (shift == ChunkDims<CHUNK_SIZE>::SHIFT && voxels->isUniform())) {
+            Voxel voxel = voxels->getVoxel(local.x, local.y, local.z);
+            return LEAF_BIT | (voxel.active ? voxel.material : MaterialId(MATERIAL_AIR));
+        }
+    }
+
+    Children children;
+    int half = 1 << (shift - 1);
+    for (int i = 0; i < 8; ++i) {
+        glm::ivec3 child = min + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * half;
+        children[i] = intern(chunks, child, shift - 1, unique);
+    }
+    return internChildren(children, unique);
+}
+
+std::optional<Voxel> SparseVoxelDag::getVoxel(const glm::ivec3& worldPos) const {
+    glm::ivec3 p = worldPos - origin;
+    int size = 1 << levels;
+    if (p.x < 0 || p.x >= size || p.y < 0 || p.y >= size || p.z < 0 || p.z >= size)
+        return std::nullopt;
+
+    std::uint32_t ref = root;
+    for (int shift = levels - 1; !(ref & LEAF_BIT); --shift)
+        ref = nodes[ref][SparseVoxelOctree::childIndex(p, shift)];
+
+    MaterialId material = MaterialId(ref & ~LEAF_BIT);
+    return Voxel{ material != MATERIAL_AIR, material };
+}
+
+SparseVoxelOctree SparseVoxelDag::toOctree() const {
+    SparseVoxelOctree octree(levels, origin);
+    expandInto(octree, 0, root);
+    return octree;
+}
+
+void SparseVoxelDag::expandInto(SparseVoxelOctree& octree, std::uint32_t octreeNode, std::uint32_t ref) const {
+    if (ref & LEAF_BIT) {
+        octree.nodes[octreeNode].material = MaterialId(ref & ~LEAF_BIT);
+        return;
+    }
+
+    std::uint32_t block = octree.allocateBlock(MATERIAL_AIR);
+    octree.nodes[octreeNode].firstChild = block;
+    for (int i = 0; i < 8; ++i)
+        expandInto(octree, block + i, nodes[ref][i]);
+}
+
+bool SparseVoxelDag::decodeCube(const glm::ivec3& worldMin, int shift, std::vector<MaterialId>& out) const {
+    glm::ivec3 p = worldMin - origin;
+    int size = 1 << levels;
+    if (shift > levels || p.x < 0 || p.x >= size || p.y < 0 || p.y >= size || p.z < 0 || p.z >= size)
+        return false;
+
+    std::uint32_t ref = root;
+    for (int s = levels - 1; s >= shift && !(ref & LEAF_BIT); --s)
+        ref = nodes[ref][SparseVoxelOctree::childIndex(p, s)];
+    if (ref == (LEAF_BIT | MATERIAL_AIR)) return false;
+
+    int edge = 1 << shift;
+    out.resize(std::size_t(edge) * edge * edge);
+    decodeInto(ref, glm::ivec3(0), shift, edge, out);
+    return true;
+}
+
+void SparseVoxelDag::decodeInto(std::uint32_t ref, const glm::ivec3& min, int shift, int edge,
+                                std::vector<MaterialId>& out) const {
+    int size = 1 << shift;
+    if (ref & LEAF_BIT) {
+        MaterialId material = MaterialId(ref & ~LEAF_BIT);
+        for (int x = min.x; x < min.x + size; ++x)
+            for (int y = min.y; y < min.y + size; ++y)
+                std::fill_n(out.begin() + (x * edge + y) * edge + min.z, size, material);
+        return;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        glm::ivec3 child = min + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * (size / 2);
+        decodeInto(nodes[ref][i], child, shift - 1, edge, out);
+    }
+}
+
+std::size_t SparseVoxelDag::memoryUsage() const {
+    return nodes.capacity() * sizeof(Children);
+}
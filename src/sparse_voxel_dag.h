@@ -0,0 +1,64 @@
+// sparse_voxel_dag.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxel.h"
+#include "sparse_voxel_octree.h"
+
+class ChunkPool;
+
+// Read-only, hash-consed form of a SparseVoxelOctree: identical subtrees (solid
+// underground bricks, flat plains, empty sky) are stored once and shared. Meant
+// for far terrain kept around for culling and collision queries. A DAG can also
+// be built straight from one ChunkPool region of world chunks (see
+// VoxelWorld::freezeRegion); to edit, thaw it back into chunks with decodeCube,
+// or into an octree with toOctree().
+class SparseVoxelDag {
+public:
+    // Cube edge of a region DAG: REGION_EDGE chunks of CHUNK_SIZE voxels
+    static constexpr int REGION_LEVELS = 3 + 4;
+
+    explicit SparseVoxelDag(const SparseVoxelOctree& octree);
+    // The region's chunks as they are now; positions holding no chunk are air
+    SparseVoxelDag(const ChunkPool& pool, const glm::ivec3& regionPos);
+
+    std::optional<Voxel> getVoxel(const glm::ivec3& worldPos) const;
+    SparseVoxelOctree toOctree() const;
+    // Materials of the aligned cube of 2^shift voxels per side at worldMin, in
+    // x, y, z order; false (out untouched) if it is all air or outside the DAG
+    bool decodeCube(const glm::ivec3& worldMin, int shift, std::vector<MaterialId>& out) const;
+
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t memoryUsage() const;
+
+private:
+    // A child reference is either an index into nodes or, with LEAF_BIT set, a material
+    static constexpr std::uint32_t LEAF_BIT = 0x80000000u;
+    using Children = std::array<std::uint32_t, 8>;
+
+    std::vector<Children> nodes;
+    std::uint32_t root = LEAF_BIT | MATERIAL_AIR;
+    int levels;
+    glm::ivec3 origin;
+
+    struct ChildrenHash {
+        std::size_t operator()(const Children& children) const;
+    };
+
+    using UniqueNodes = std::unordered_map<Children, std::uint32_t, ChildrenHash>;
+    struct RegionChunks;
+
+    // Shares an existing node with the same children, or adds one; eight equal
+    // leaves collapse into that leaf
+    std::uint32_t internChildren(const Children& children, UniqueNodes& unique);
+    std::uint32_t intern(const SparseVoxelOctree& octree, std::uint32_t node, UniqueNodes& unique);
+    std::uint32_t intern(const RegionChunks& chunks, const glm::ivec3& min, int shift, UniqueNodes& unique);
+    void expandInto(SparseVoxelOctree& octree, std::uint32_t octreeNode, std::uint32_t ref) const;
+    void decodeInto(std::uint32_t ref, const glm::ivec3& min, int shift, int edge, std::vector<MaterialId>& out) const;
+};
@@ -0,0 +1,93 @@
+// sparse_voxel_octree.cpp
+#include "sparse_voxel_octree.h"
+
+namespace {
+    constexpr int MAX_LEVELS = 30;
+}
+
+SparseVoxelOctree::SparseVoxelOctree(int levels, const glm::ivec3& origin)
+    : levels(levels < MAX_LEVELS ? levels : MAX_LEVELS), origin(origin) {
+    nodes.push_back(Node{});
+}
+
+bool SparseVoxelOctree::contains(const glm::ivec3& local) const {
+    int size = 1 << levels;
+    return local.x >= 0 && local.x < size &&
+           local.y >= 0 && local.y < size &&
+           local.z >= 0 && local.z < size;
+}
+
+std::optional<Voxel> SparseVoxelOctree::getVoxel(const glm::ivec3& worldPos) const {
+    glm::ivec3 p = worldPos - origin;
+    if (!contains(p)) return std::nullopt;
+
+    std::uint32_t node = 0;
+    for (int shift = levels - 1; nodes[node].firstChild != 0; --shift)
+        node = nodes[node].firstChild + childIndex(p, shift);
+
+    MaterialId material = nodes[node].material;
+    return Voxel{ material != MATERIAL_AIR, material };
+}
+
+void SparseVoxelOctree::deactivateVoxel(const glm::ivec3& worldPos) {
+    setVoxel(worldPos, Voxel{ false });
+}
+
+void SparseVoxelOctree::setVoxel(const glm::ivec3& worldPos, const Voxel& voxel) {
+    glm::ivec3 p = worldPos - origin;
+    if (!contains(p)) return;
+
+    MaterialId material = voxel.active ? voxel.material : MaterialId(MATERIAL_AIR);
+
+    // Descend, splitting homogeneous leaves that disagree with the new value
+    std::uint32_t path[MAX_LEVELS];
+    int depth = 0;
+    std::uint32_t node = 0;
+    for (int shift = levels - 1; shift >= 0; --shift) {
+        if (nodes[node].firstChild == 0) {
+            if (nodes[node].material == material) return;
+            std::uint32_t block = allocateBlock(nodes[node].material);
+            nodes[node].firstChild = block;
+        }
+        path[depth++] = node;
+        node = nodes[node].firstChild + childIndex(p, shift);
+    }
+
+    if (nodes[node].material == material) return;
+    nodes[node].material = material;
+
+    // Climb back up, folding any parent whose 8 children are now identical leaves
+    while (depth > 0) {
+        std::uint32_t parent = path[--depth];
+        std::uint32_t first = nodes[parent].firstChild;
+        for (int i = 0; i < 8; ++i) {
+            const Node& child = nodes[first + i];
+            if (child.firstChild != 0 || child.material != material) return;
+        }
+        freeBlock(first);
+        nodes[parent].firstChild = 0;
+        nodes[parent].material = material;
+    }
+}
+
+std::size_t SparseVoxelOctree::memoryUsage() const {
+    return nodes.capacity() * sizeof(Node) + freeBlocks.capacity() * sizeof(std::uint32_t);
+}
+
+std::uint32_t SparseVoxelOctree::allocateBlock(MaterialId fill) {
+    std::uint32_t first;
+    if (!freeBlocks.empty()) {
+        first = freeBlocks.back();
+        freeBlocks.pop_back();
+    } else {
+        first = std::uint32_t(nodes.size());
+        nodes.resize(nodes.size() + 8);
+    }
+    for (int i = 0; i < 8; ++i)
+        nodes[first + i] = Node{ 0, fill };
+    return first;
+}
+
+void SparseVoxelOctree::freeBlock(std::uint32_t first) {
+    freeBlocks.push_back(first);
+}
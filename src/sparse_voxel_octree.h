@@ -0,0 +1,50 @@
+// sparse_voxel_octree.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxel.h"
+
+// Sparse voxel octree over a cube of 2^levels voxels per side, exposing the
+// same getVoxel/deactivateVoxel API as VoxelWorld. Homogeneous subtrees collapse
+// into a single leaf, so memory follows surface complexity rather than volume.
+// Nodes live in a pool of 8-sibling blocks recycled through a free list, and
+// both queries and edits walk the tree iteratively.
+class SparseVoxelOctree {
+public:
+    explicit SparseVoxelOctree(int levels, const glm::ivec3& origin = glm::ivec3(0));
+
+    std::optional<Voxel> getVoxel(const glm::ivec3& worldPos) const;
+    void deactivateVoxel(const glm::ivec3& worldPos);
+    void setVoxel(const glm::ivec3& worldPos, const Voxel& voxel);
+
+    int getLevels() const { return levels; }
+    const glm::ivec3& getOrigin() const { return origin; }
+    std::size_t nodeCount() const { return nodes.size() - freeBlocks.size() * 8; }
+    std::size_t memoryUsage() const;
+
+    // Which of the 8 children holds p (relative to origin) at a node whose children are 2^shift wide
+    static int childIndex(const glm::ivec3& p, int shift) {
+        return ((p.x >> shift) & 1) | ((p.y >> shift) & 1) << 1 | ((p.z >> shift) & 1) << 2;
+    }
+
+private:
+    friend class SparseVoxelDag;
+
+    struct Node {
+        std::uint32_t firstChild = 0;       // First of 8 sibling nodes, 0 = leaf (the root is node 0)
+        MaterialId material = MATERIAL_AIR; // Leaf value for the whole subtree
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> freeBlocks;
+    int levels;
+    glm::ivec3 origin;
+
+    bool contains(const glm::ivec3& local) const;
+    std::uint32_t allocateBlock(MaterialId fill);
+    void freeBlock(std::uint32_t first);
+};
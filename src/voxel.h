@@ -1,7 +1,22 @@
 // voxel.h
 #pragma once
 
+#include <cstdint>
+
+using MaterialId = std::uint16_t;
+
+enum Material : MaterialId {
+    MATERIAL_AIR = 0,
+    MATERIAL_GRASS,
+    MATERIAL_DIRT,
+    MATERIAL_STONE
+};
+
+// Per-voxel attributes kept outside Voxel, each in its own chunk channel (see VoxelChannel)
+using LightLevel = std::uint8_t;  // 0 = dark
+using DamageLevel = std::uint8_t; // 0 = intact
+
 struct Voxel {
     bool active = true;
-    // Add material/type info later
+    MaterialId material = MATERIAL_DIRT; // Inactive voxels read back as MATERIAL_AIR
 };
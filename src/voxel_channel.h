@@ -0,0 +1,42 @@
+// voxel_channel.h
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// One per-voxel attribute stored as its own dense array, so a pass over it
+// streams only that attribute. Nothing is allocated until a voxel is set to
+// something other than the fill value; until then every voxel reads as it.
+template <typename T>
+class VoxelChannel {
+public:
+    explicit VoxelChannel(std::size_t size, T initial = T{}) : count(size), initial(initial) {}
+
+    T get(std::size_t index) const { return values.empty() ? initial : values[index]; }
+
+    // Returns false if the voxel already held value
+    bool set(std::size_t index, T value) {
+        if (get(index) == value) return false;
+        if (values.empty()) values.assign(count, initial);
+        values[index] = value;
+        return true;
+    }
+
+    // Sets every voxel and releases the array
+    void fill(T value) {
+        initial = value;
+        values.clear();
+        values.shrink_to_fit();
+    }
+
+    bool isAllocated() const { return !values.empty(); }
+    // The raw array in voxelIndex order; empty while unallocated
+    std::span<const T> data() const { return values; }
+    std::size_t memoryUsage() const { return values.capacity() * sizeof(T); }
+
+private:
+    std::size_t count;
+    T initial;
+    std::vector<T> values;
+};
@@ -2,125 +2,627 @@
 #include "shader.h"
 #include "cube_renderer.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
 #include "voxel_utils.h"
 
-VoxelChunk::VoxelChunk() {
-    dirty = true;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    for (int x = 0; x < CHUNK_SIZE; ++x)
-        for (int y = 0; y < CHUNK_SIZE; ++y)
-            for (int z = 0; z < CHUNK_SIZE; ++z)
-                voxels[x][y][z].active = false;
-}
-
-void VoxelChunk::generateTerrainChunk(const glm::ivec3& chunkPos, int maxHeight) {
-    for (int x = 0; x < CHUNK_SIZE; ++x)
-        for (int y = 0; y < CHUNK_SIZE; ++y)
-            for (int z = 0; z < CHUNK_SIZE; ++z)
-                voxels[x][y][z].active = y < maxHeight / 2;
-
-    dirty = true;
-}
-void VoxelChunk::appendFace(FaceDirection dir, const glm::vec3& pos) {
-    static const std::vector<float> faceVertices[6] = {
-        // Right
-        { 0.5f,-0.5f,-0.5f, 1,0,0,  0.5f,-0.5f, 0.5f, 1,0,0,  0.5f, 0.5f, 0.5f, 1,0,0,
-          0.5f, 0.5f, 0.5f, 1,0,0,  0.5f, 0.5f,-0.5f, 1,0,0,  0.5f,-0.5f,-0.5f, 1,0,0 },
-        // Left
-        { -0.5f,-0.5f, 0.5f,-1,0,0, -0.5f,-0.5f,-0.5f,-1,0,0, -0.5f, 0.5f,-0.5f,-1,0,0,
-         -0.5f, 0.5f,-0.5f,-1,0,0, -0.5f, 0.5f, 0.5f,-1,0,0, -0.5f,-0.5f, 0.5f,-1,0,0 },
-        // Top
-        { -0.5f, 0.5f,-0.5f, 0,1,0,  0.5f, 0.5f,-0.5f, 0,1,0,  0.5f, 0.5f, 0.5f, 0,1,0,
-          0.5f, 0.5f, 0.5f, 0,1,0, -0.5f, 0.5f, 0.5f, 0,1,0, -0.5f, 0.5f,-0.5f, 0,1,0 },
-        // Bottom
-        { -0.5f,-0.5f,-0.5f, 0,-1,0,  0.5f,-0.5f,-0.5f, 0,-1,0,  0.5f,-0.5f, 0.5f, 0,-1,0,
-          0.5f,-0.5f, 0.5f, 0,-1,0, -0.5f,-0.5f, 0.5f, 0,-1,0, -0.5f,-0.5f,-0.5f, 0,-1,0 },
-        // Front
-        { -0.5f,-0.5f, 0.5f, 0,0,1,  0.5f,-0.5f, 0.5f, 0,0,1,  0.5f, 0.5f, 0.5f, 0,0,1,
-          0.5f, 0.5f, 0.5f, 0,0,1, -0.5f, 0.5f, 0.5f, 0,0,1, -0.5f,-0.5f, 0.5f, 0,0,1 },
-        // Back
-        { -0.5f,-0.5f,-0.5f, 0,0,-1,  0.5f,-0.5f,-0.5f, 0,0,-1,  0.5f, 0.5f,-0.5f, 0,0,-1,
-          0.5f, 0.5f,-0.5f, 0,0,-1, -0.5f, 0.5f,-0.5f, 0,0,-1, -0.5f,-0.5f,-0.5f, 0,0,-1 }
+namespace {
+    // Element buffer shared by every chunk mesh of one size: quad q is vertices
+    // 4q..4q+3, drawn as triangles 0-1-2 and 2-3-0, so meshes store 4 vertices
+    // per quad and no indices. Sized for the most quads a chunk can produce (a
+    // checkerboard, three faces per voxel), built on first upload and kept for
+    // the lifetime of the GL context.
+    template <int Size>
+    struct QuadIndices {
+        static constexpr std::size_t MAX_QUADS = 3 * std::size_t(Size) * Size * Size;
+        using Index = std::conditional_t<MAX_QUADS * 4 <= 65536, std::uint16_t, std::uint32_t>;
+        static constexpr GLenum TYPE = sizeof(Index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        static GLuint buffer() {
+            static GLuint ebo = 0;
+            if (ebo != 0) return ebo;
+
+            std::vector<Index> indices(MAX_QUADS * 6);
+            for (std::size_t q = 0; q < MAX_QUADS; ++q) {
+                Index base = Index(q * 4);
+                Index quad[6] = { base, Index(base + 1), Index(base + 2), Index(base + 2), Index(base + 3), base };
+                std::copy(quad, quad + 6, indices.begin() + q * 6);
+            }
+            glGenBuffers(1, &ebo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(Index), indices.data(), GL_STATIC_DRAW);
+            return ebo;
+        }
     };
 
-    const auto& verts = faceVertices[int(dir)];
-    for (size_t i = 0; i < verts.size(); i += 6) {
-        meshData.push_back(verts[i + 0] + pos.x);
-        meshData.push_back(verts[i + 1] + pos.y);
-        meshData.push_back(verts[i + 2] + pos.z);
-        meshData.push_back(verts[i + 3]);
-        meshData.push_back(verts[i + 4]);
-        meshData.push_back(verts[i + 5]);
+    // Shared by every chunk that has not been written yet; never modified
+    template <int Size>
+    const std::shared_ptr<const BasicChunkVoxels<Size>>& emptyVoxels() {
+        static const std::shared_ptr<const BasicChunkVoxels<Size>> empty = std::make_shared<const BasicChunkVoxels<Size>>();
+        return empty;
+    }
+}
+
+template <int Size>
+BasicVoxelChunk<Size>::BasicVoxelChunk(const glm::ivec3& chunkPos) : published(emptyVoxels<Size>()), head(emptyVoxels<Size>()), chunkPos(chunkPos) {
+    invalidateMesh();
+}
+
+template <int Size>
+BasicVoxelChunk<Size>::~BasicVoxelChunk() {
+    releaseGlObjects();
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::releaseGlObjects() {
+    if (VAO != 0) {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        VAO = VBO = 0;
+    }
+}
+
+template <int Size>
+auto BasicVoxelChunk<Size>::edit() -> Voxels& {
+    if (!draft) draft = std::make_shared<Voxels>(*head);
+    return *draft;
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::publish() {
+    if (!draft) return;
+    head = std::move(draft);
+    published.store(head, std::memory_order_release);
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::reset(const glm::ivec3& newChunkPos) {
+    chunkPos = newChunkPos;
+    draft.reset();
+    head = emptyVoxels<Size>();
+    published.store(head, std::memory_order_release);
+    sectionMesh.reset();
+    seamQuads.reset();
+    meshVertices = 0;
+    // Versions start over with the empty contents
+    meshedVersion = savedVersion = 0;
+    stored = false;
+    lastAccess = 0;
+    invalidateMesh();
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::invalidateMesh(int x, int y, int z) {
+    if (Voxels::contains(x, y, z))
+        invalidBricks.set(Versions::brickIndex(x / Versions::BRICK, y / Versions::BRICK, z / Versions::BRICK));
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::invalidateBorder(FaceDirection dir) {
+    constexpr int BRICKS = Versions::BRICKS;
+    int axis = int(dir) / 2;
+    int brick[3];
+    brick[axis] = int(dir) % 2 == 0 ? BRICKS - 1 : 0;
+    for (int i = 0; i < BRICKS; ++i) {
+        for (int j = 0; j < BRICKS; ++j) {
+            brick[(axis + 1) % 3] = i;
+            brick[(axis + 2) % 3] = j;
+            invalidBricks.set(Versions::brickIndex(brick[0], brick[1], brick[2]));
+        }
+    }
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::fill(const Voxel& voxel) {
+    edit().fill(voxel);
+}
+
+template <int Size>
+bool BasicVoxelChunk<Size>::compactColumns() {
+    if (voxels().getStorage() == ChunkStorage::Columns) return true;
+    // Same contents in a different encoding, so the mesh stays valid
+    return edit().compactColumns();
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::setColumnRuns(int x, int z, std::span<const VoxelRun> runs) {
+    edit().setColumnRuns(x, z, runs);
+    // As in setVoxel, for the side neighbours of the whole column
+    for (int y = 0; y < Size; y += Versions::BRICK) {
+        invalidateMesh(x + 1, y, z);
+        invalidateMesh(x - 1, y, z);
+        invalidateMesh(x, y, z + 1);
+        invalidateMesh(x, y, z - 1);
     }
 }
 
+template <int Size>
+void BasicVoxelChunk<Size>::generateTerrainChunk(int maxHeight) {
+    // Flat up to half of maxHeight in world rows, so stacked chunks line up
+    for (int x = 0; x < Size; ++x)
+        for (int y = 0; y < Size; ++y)
+            for (int z = 0; z < Size; ++z)
+                setVoxel(x, y, z, Voxel{ chunkPos.y * Size + y < maxHeight / 2 });
+}
+template <int Size>
+void BasicVoxelChunk<Size>::appendQuad(std::vector<ChunkVertex>& out, FaceDirection dir, const glm::ivec3& pos, const glm::ivec3& size) {
+    // Corners of the unit face of voxel (0, 0, 0), counter-clockwise from the
+    // outside; the shared index buffer makes them triangles 0-1-2 and 2-3-0
+    static constexpr int corners[6][4][3] = {
+        { {1,0,0}, {1,0,1}, {1,1,1}, {1,1,0} }, // Right
+        { {0,0,1}, {0,0,0}, {0,1,0}, {0,1,1} }, // Left
+        { {0,1,0}, {1,1,0}, {1,1,1}, {0,1,1} }, // Top
+        { {0,0,0}, {1,0,0}, {1,0,1}, {0,0,1} }, // Bottom
+        { {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1} }, // Front
+        { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0} }  // Back
+    };
+
+    // The unit face stretched over size voxels
+    for (const auto& c : corners[int(dir)])
+        out.push_back(packChunkVertex(pos.x + c[0] * size.x, pos.y + c[1] * size.y, pos.z + c[2] * size.z, dir));
+}
+
             
 
  
-bool VoxelChunk::isVoxelSolid(int x, int y, int z) const {
-    if (x < 0 || x >= CHUNK_SIZE ||
-        y < 0 || y >= CHUNK_SIZE ||
-        z < 0 || z >= CHUNK_SIZE)
-        return false;
-    return voxels[x][y][z].active;
-}
-
-void VoxelChunk::updateMesh() {
-    meshData.clear();
-
-    for (int x = 0; x < CHUNK_SIZE; ++x) {
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int z = 0; z < CHUNK_SIZE; ++z) {
-                if (!voxels[x][y][z].active) continue;
-                glm::vec3 pos = glm::vec3(x, y, z);
-                if (!isVoxelSolid(x + 1, y, z)) appendFace(FaceDirection::Right, pos);
-                if (!isVoxelSolid(x - 1, y, z)) appendFace(FaceDirection::Left, pos);
-                if (!isVoxelSolid(x, y + 1, z)) appendFace(FaceDirection::Top, pos);
-                if (!isVoxelSolid(x, y - 1, z)) appendFace(FaceDirection::Bottom, pos);
-                if (!isVoxelSolid(x, y, z + 1)) appendFace(FaceDirection::Front, pos);
-                if (!isVoxelSolid(x, y, z - 1)) appendFace(FaceDirection::Back, pos);
+template <int Size>
+bool BasicVoxelChunk<Size>::isVoxelSolid(int x, int y, int z) const {
+    return voxels().isVoxelSolid(x, y, z);
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::appendFaces(std::vector<ChunkVertex>& out, FaceDirection dir, Row faces, int x, int y) {
+    while (faces) {
+        int z = std::countr_zero(faces);
+        faces &= faces - 1;
+        appendQuad(out, dir, glm::ivec3(x, y, z), glm::ivec3(1));
+    }
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::buildMesh(const Neighbours& neighbours, MeshMode mode) {
+    BrickMask all;
+    rebuildSections(neighbours, all.set(), mode);
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::rebuildSections(const Neighbours& neighbours, const BrickMask& stale, MeshMode mode) {
+    meshedVersion = voxels().getVersions().getVersion();
+    meshedMode = mode;
+    invalidBricks.reset();
+
+    // Air has no faces whatever its neighbours are, and neither has a solid
+    // chunk buried in solid neighbours
+    const Voxels& contents = voxels();
+    const OccupancySummary<Size>& summary = contents.getSummary();
+    bool buried = summary.allSolid() && std::all_of(neighbours.begin(), neighbours.end(),
+        [](const Voxels* n) { return n && n->getSummary().allSolid(); });
+    if (!summary.anySolid() || buried) {
+        sectionMesh.reset();
+        seamQuads.reset();
+        meshVertices = 0;
+        return;
+    }
+    // Dropped only while every section is empty, so a partial rebuild loses nothing
+    if (!sectionMesh) sectionMesh = std::make_unique<SectionMeshes>();
+    if (mode == MeshMode::Greedy && !seamQuads) seamQuads = std::make_unique<SeamQuads>();
+
+    // Reused between builds on the same thread
+    static thread_local PaddedOccupancy<Size> padded;
+    padded.build(contents, neighbours);
+
+    // A section's faces only depend on its own rows and the padded rows around
+    // them, so each stale section is rebuilt on its own and the rest are kept
+    constexpr int BRICKS = Versions::BRICKS;
+    // A full rebuild merges every seam slab again; otherwise only those whose quads changed
+    SlabMask seamsChanged;
+    if (stale.all()) seamsChanged.set();
+    for (int section = 0; section < SECTIONS; ++section) {
+        bool sectionStale = false;
+        for (int bz = 0; bz < BRICKS; ++bz)
+            sectionStale |= stale[section * BRICKS + bz];
+        if (sectionStale && mode == MeshMode::Greedy) meshGreedy(padded, section, seamsChanged);
+        else if (sectionStale) meshRows(padded, section);
+    }
+
+    if (mode == MeshMode::Greedy) {
+        if (seamsChanged.any()) mergeSeams(seamsChanged);
+    } else {
+        // Left over from greedy mode
+        for (int slab = 0; slab < SEAM_SLABS; ++slab) (*sectionMesh)[SECTIONS + slab].clear();
+        seamQuads.reset();
+    }
+
+    meshVertices = 0;
+    for (const std::vector<ChunkVertex>& section : *sectionMesh) meshVertices += section.size();
+    if (meshVertices == 0) {
+        sectionMesh.reset();
+        seamQuads.reset();
+    }
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::meshRows(const PaddedOccupancy<Size>& padded, int section) {
+    // Whole rows at a time: a face is exposed where this row is set and the
+    // neighbour row is not. The apron makes every neighbour row readable.
+    std::vector<ChunkVertex>& out = (*sectionMesh)[section];
+    out.clear();
+    constexpr int BRICK = Versions::BRICK;
+    int x0 = section / Versions::BRICKS * BRICK, y0 = section % Versions::BRICKS * BRICK;
+    for (int x = x0; x < x0 + BRICK; ++x) {
+        for (int y = y0; y < y0 + BRICK; ++y) {
+            Row row = padded.row(x, y);
+            if (!row) continue;
+            appendFaces(out, FaceDirection::Right,  row & ~padded.row(x + 1, y), x, y);
+            appendFaces(out, FaceDirection::Left,   row & ~padded.row(x - 1, y), x, y);
+            appendFaces(out, FaceDirection::Top,    row & ~padded.row(x, y + 1), x, y);
+            appendFaces(out, FaceDirection::Bottom, row & ~padded.row(x, y - 1), x, y);
+            appendFaces(out, FaceDirection::Front,  row & ~(Row(row >> 1) | padded.frontApron(x, y)), x, y);
+            appendFaces(out, FaceDirection::Back,   row & ~(Row(row << 1) | padded.backApron(x, y)), x, y);
+        }
+    }
+}
+
+namespace {
+    // Greedy merge of one slice given as bit rows: bit v of rows[u] is a face at
+    // (u, v). Each run of set bits is taken whole (ctz/countr_one), then grown
+    // across u while the next row holds the entire run; emit(u, v, height, width).
+    // Rows are the chunk's occupancy words (OccupancyRowFor<Size>), one bit per
+    // voxel, so a 16^3 chunk merges 16-bit masks and a 64^3 one 64-bit masks;
+    // a wider word would only carry zero bits past the chunk edge.
+    template <typename Row>
+    Row runBits(int v, int width) {
+        return width == int(sizeof(Row) * 8) ? Row(~Row(0)) : Row(((Row(1) << width) - 1) << v);
+    }
+
+    template <typename Row, typename Emit>
+    void mergeRows(Row* rows, int count, Emit&& emit) {
+        for (int u = 0; u < count; ++u) {
+            while (rows[u]) {
+                int v = std::countr_zero(rows[u]);
+                int width = std::countr_one(Row(rows[u] >> v));
+                Row run = runBits<Row>(v, width);
+                int height = 1;
+                while (u + height < count && (rows[u + height] & run) == run)
+                    rows[u + height++] &= Row(~run);
+                rows[u] &= Row(~run);
+                emit(u, v, height, width);
+            }
+        }
+    }
+
+    // A section's four rows at one x (or y) turned sideways for the slices
+    // across z: bit z of rows[d] goes to bit d of column z, four bits per column
+    // and sixteen columns per word
+    template <typename Row>
+    struct RowColumns {
+        std::uint64_t words[(sizeof(Row) * 8 + 15) / 16];
+
+        explicit RowColumns(const Row (&rows)[4]) {
+            // Spreads 16 bits out to every fourth bit
+            auto spread = [](std::uint64_t x) {
+                x = (x | x << 24) & 0x000000FF000000FF;
+                x = (x | x << 12) & 0x000F000F000F000F;
+                x = (x | x << 6) & 0x0303030303030303;
+                return (x | x << 3) & 0x1111111111111111;
+            };
+            for (int w = 0; w < int(std::size(words)); ++w) {
+                words[w] = 0;
+                for (int d = 0; d < 4; ++d) words[w] |= spread(std::uint64_t(rows[d]) >> (16 * w) & 0xFFFF) << d;
+            }
+        }
+        unsigned at(int z) const { return unsigned(words[z >> 4] >> (4 * (z & 15))) & 0xF; }
+    };
+
+    // Slices across x have u = y and v = z, across y u = x and v = z, across z
+    // u = x and v = y: v is always the lower remaining axis, so rows along z
+    // serve x and y slices as they are
+    glm::ivec3 slicePoint(int axis, int slice, int u, int v) {
+        return axis == 0 ? glm::ivec3(slice, u, v) : axis == 1 ? glm::ivec3(u, slice, v) : glm::ivec3(u, v, slice);
+    }
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::meshGreedy(const PaddedOccupancy<Size>& padded, int section, SlabMask& changed) {
+    constexpr int BRICK = Versions::BRICK;
+    std::vector<ChunkVertex>& out = (*sectionMesh)[section];
+    std::vector<SeamQuad>& seams = (*seamQuads)[section];
+    // Kept to compare against once the section is rebuilt
+    static thread_local std::vector<SeamQuad> previous;
+    previous.swap(seams);
+    out.clear();
+    seams.clear();
+    int x0 = section / Versions::BRICKS * BRICK, y0 = section % Versions::BRICKS * BRICK;
+
+    // Exposed faces per direction for each of the section's rows, as meshRows finds them
+    Row faces[6][BRICK][BRICK];
+    for (int dx = 0; dx < BRICK; ++dx) {
+        for (int dy = 0; dy < BRICK; ++dy) {
+            int x = x0 + dx, y = y0 + dy;
+            Row row = padded.row(x, y);
+            faces[int(FaceDirection::Right)][dx][dy]  = row & ~padded.row(x + 1, y);
+            faces[int(FaceDirection::Left)][dx][dy]   = row & ~padded.row(x - 1, y);
+            faces[int(FaceDirection::Top)][dx][dy]    = row & ~padded.row(x, y + 1);
+            faces[int(FaceDirection::Bottom)][dx][dy] = row & ~padded.row(x, y - 1);
+            faces[int(FaceDirection::Front)][dx][dy]  = row & ~(Row(row >> 1) | padded.frontApron(x, y));
+            faces[int(FaceDirection::Back)][dx][dy]   = row & ~(Row(row << 1) | padded.backApron(x, y));
+        }
+    }
+
+    // Faces only merge within a material: the exposed voxels are split into one
+    // row mask per material present (terrain sections have one to three), read
+    // from the palette words or column runs once for the whole section
+    Row exposed[BRICK][BRICK];
+    for (int dx = 0; dx < BRICK; ++dx) {
+        for (int dy = 0; dy < BRICK; ++dy) {
+            exposed[dx][dy] = 0;
+            for (int dir = 0; dir < 6; ++dir) exposed[dx][dy] |= faces[dir][dx][dy];
+        }
+    }
+    static thread_local std::vector<typename Voxels::MaterialLayer> layers;
+    voxels().materialLayers(section / Versions::BRICKS, section % Versions::BRICKS, exposed, layers);
+
+    // Quads are merged within the section's rows. One reaching the rows' edge
+    // with solid voxels right beyond it, in another section, may continue there,
+    // so it goes to its seam slab; the rest are final. Only the rows next to the
+    // section are read, so edits that change the answer stale it as well. At the
+    // chunk's borders those rows count as empty: nothing continues past them.
+    Row belowX[BRICK], aboveX[BRICK], belowY[BRICK], aboveY[BRICK];
+    for (int d = 0; d < BRICK; ++d) {
+        belowX[d] = x0 > 0 ? padded.row(x0 - 1, y0 + d) : Row(0);
+        aboveX[d] = x0 + BRICK < Size ? padded.row(x0 + BRICK, y0 + d) : Row(0);
+        belowY[d] = y0 > 0 ? padded.row(x0 + d, y0 - 1) : Row(0);
+        aboveY[d] = y0 + BRICK < Size ? padded.row(x0 + d, y0 + BRICK) : Row(0);
+    }
+    static_assert(BRICK == 4, "slices across z take a section's rows four bits at a time");
+    const RowColumns<Row> belowXColumns(belowX), aboveXColumns(aboveX), belowYColumns(belowY), aboveYColumns(aboveY);
+    Row layerFaces[6][BRICK][BRICK], rows[BRICK];
+    for (const typename Voxels::MaterialLayer& layer : layers) {
+        Row any[6] = {};
+        for (int dir = 0; dir < 6; ++dir) {
+            for (int dx = 0; dx < BRICK; ++dx) {
+                for (int dy = 0; dy < BRICK; ++dy) {
+                    layerFaces[dir][dx][dy] = faces[dir][dx][dy] & layer.rows[dx][dy];
+                    any[dir] |= layerFaces[dir][dx][dy];
+                }
+            }
+        }
+        for (int dir = 0; dir < 6; ++dir) {
+            if (!any[dir]) continue;
+            FaceDirection face = FaceDirection(dir);
+            int axis = dir / 2;
+            auto emit = [&](int slice, int u, int v, int height, int width) {
+                bool seam = false;
+                if (axis == 0) {
+                    Row run = runBits<Row>(v, width);
+                    seam = (u == y0 && (belowY[slice - x0] & run)) ||
+                           (u + height == y0 + BRICK && (aboveY[slice - x0] & run));
+                } else if (axis == 1) {
+                    Row run = runBits<Row>(v, width);
+                    seam = (u == x0 && (belowX[slice - y0] & run)) ||
+                           (u + height == x0 + BRICK && (aboveX[slice - y0] & run));
+                } else {
+                    unsigned across = runBits<unsigned>(v - y0, width), along = runBits<unsigned>(u - x0, height);
+                    seam = (u == x0 && (belowXColumns.at(slice) & across)) ||
+                           (u + height == x0 + BRICK && (aboveXColumns.at(slice) & across)) ||
+                           (v == y0 && (belowYColumns.at(slice) & along)) ||
+                           (v + width == y0 + BRICK && (aboveYColumns.at(slice) & along));
+                }
+                if (!seam) {
+                    appendQuad(out, face, slicePoint(axis, slice, u, v), slicePoint(axis, 1, height, width));
+                } else {
+                    seams.push_back(SeamQuad{ std::uint8_t(dir), std::uint8_t(slice), std::uint8_t(u), std::uint8_t(v),
+                                              std::uint8_t(height), std::uint8_t(width), layer.material });
+                }
+            };
+            if (axis == 0) {
+                // Slices across x; u = y, bits along z
+                for (int dx = 0; dx < BRICK; ++dx) {
+                    for (int dy = 0; dy < BRICK; ++dy) rows[dy] = layerFaces[dir][dx][dy];
+                    mergeRows(rows, BRICK, [&](int u, int v, int height, int width) {
+                        emit(x0 + dx, y0 + u, v, height, width);
+                    });
+                }
+            } else if (axis == 1) {
+                // Slices across y; u = x, bits along z
+                for (int dy = 0; dy < BRICK; ++dy) {
+                    for (int dx = 0; dx < BRICK; ++dx) rows[dx] = layerFaces[dir][dx][dy];
+                    mergeRows(rows, BRICK, [&](int u, int v, int height, int width) {
+                        emit(y0 + dy, x0 + u, v, height, width);
+                    });
+                }
+            } else {
+                // Slices across z; u = x, bits along y, read from the rows turned sideways
+                const RowColumns<Row> columns[BRICK] = {
+                    RowColumns<Row>(layerFaces[dir][0]), RowColumns<Row>(layerFaces[dir][1]),
+                    RowColumns<Row>(layerFaces[dir][2]), RowColumns<Row>(layerFaces[dir][3])
+                };
+                for (Row bits = any[dir]; bits; bits &= bits - 1) {
+                    int z = std::countr_zero(bits);
+                    unsigned slice[BRICK] = { columns[0].at(z), columns[1].at(z), columns[2].at(z), columns[3].at(z) };
+                    mergeRows(slice, BRICK, [&](int u, int v, int height, int width) {
+                        emit(z, x0 + u, y0 + v, height, width);
+                    });
+                }
+            }
+        }
+    }
+
+    // The same faces come out as the same quads in the same order, so a slab is
+    // unchanged where its quads before and after match one for one
+    if (seams == previous) return;
+    for (int slab = 0; slab < SEAM_SLABS; ++slab) {
+        if (changed[slab]) continue;
+        auto inSlab = [&](const SeamQuad& quad) { return quad.slab() == slab; };
+        auto a = std::find_if(previous.cbegin(), previous.cend(), inSlab);
+        auto b = std::find_if(seams.cbegin(), seams.cend(), inSlab);
+        while (a != previous.cend() && b != seams.cend() && *a == *b) {
+            a = std::find_if(a + 1, previous.cend(), inSlab);
+            b = std::find_if(b + 1, seams.cend(), inSlab);
+        }
+        if (a != previous.cend() || b != seams.cend()) changed.set(slab);
+    }
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::mergeSeams(const SlabMask& slabs) {
+    // The seam quads drawn back into bit rows, one plane per direction, slice
+    // and material, indexed by (direction, slice) and chained by material
+    struct Plane {
+        std::uint8_t dir, slice;
+        MaterialId material;
+        int next;
+        Row rows[Size];
+    };
+    static thread_local std::vector<Plane> planes;
+    planes.clear();
+    int first[6][Size];
+    std::fill(&first[0][0], &first[0][0] + 6 * Size, -1);
+    for (const std::vector<SeamQuad>& seams : *seamQuads) {
+        for (const SeamQuad& quad : seams) {
+            if (!slabs[quad.slab()]) continue;
+            int plane = first[quad.dir][quad.slice];
+            while (plane >= 0 && planes[plane].material != quad.material) plane = planes[plane].next;
+            if (plane < 0) {
+                plane = int(planes.size());
+                planes.push_back(Plane{ quad.dir, quad.slice, quad.material, first[quad.dir][quad.slice], {} });
+                first[quad.dir][quad.slice] = plane;
             }
+            Row run = runBits<Row>(quad.v, quad.width);
+            for (int u = quad.u; u < quad.u + quad.height; ++u) planes[plane].rows[u] |= run;
         }
     }
 
-    uploadMesh();
-    dirty = false;
+    // Merged again across the whole slice, into the slab's section
+    for (int slab = 0; slab < SEAM_SLABS; ++slab)
+        if (slabs[slab]) (*sectionMesh)[SECTIONS + slab].clear();
+    for (Plane& plane : planes) {
+        int axis = plane.dir / 2;
+        std::vector<ChunkVertex>& out = (*sectionMesh)[SECTIONS + axis * Versions::BRICKS + plane.slice / Versions::BRICK];
+        mergeRows(plane.rows, Size, [&](int u, int v, int height, int width) {
+            appendQuad(out, FaceDirection(plane.dir), slicePoint(axis, plane.slice, u, v),
+                       slicePoint(axis, 1, height, width));
+        });
+    }
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::refreshMesh(const Neighbours& neighbours, MeshMode mode) {
+    BrickMask stale = staleBricks();
+    if (mode != meshedMode) stale.set();
+    if (stale.any()) rebuildSections(neighbours, stale, mode);
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::updateMesh(const Neighbours& neighbours, MeshMode mode) {
+    refreshMesh(neighbours, mode);
+    if (meshVertices == 0) releaseGlObjects();
+    else uploadMesh();
 }
 
-void VoxelChunk::uploadMesh() {
-    if (meshData.empty()) return;
+template <int Size>
+void BasicVoxelChunk<Size>::uploadMesh() {
+    if (meshVertices == 0) return;
+
+    if (VAO == 0) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+    }
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-    glBufferData(GL_ARRAY_BUFFER, meshData.size() * sizeof(float), meshData.data(), GL_STATIC_DRAW);
+    // Sections back to back; the buffer is respecified so the driver need not wait on the old one
+    glBufferData(GL_ARRAY_BUFFER, meshVertices * sizeof(ChunkVertex), nullptr, GL_STATIC_DRAW);
+    GLintptr offset = 0;
+    for (const std::vector<ChunkVertex>& section : *sectionMesh) {
+        if (section.empty()) continue;
+        glBufferSubData(GL_ARRAY_BUFFER, offset, section.size() * sizeof(ChunkVertex), section.data());
+        offset += GLintptr(section.size() * sizeof(ChunkVertex));
+    }
 
-    // layout(location = 0) -> vec3 position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    // layout(location = 0) -> uint packed vertex, read as an integer (not converted to float)
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // layout(location = 1) -> vec3 normal
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // The element buffer binding is part of the VAO, so draw() needs nothing more
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, QuadIndices<Size>::buffer());
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
 
-void VoxelChunk::draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj) {
-    glm::mat4 model(1.0f);
+template <int Size>
+void BasicVoxelChunk<Size>::draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj) {
+    if (meshVertices == 0) return;
+
+    // Mesh vertices are chunk-local, place the chunk at its world origin
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(chunkPos * Size));
     shader.setMat4("model", glm::value_ptr(model));
     glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, meshData.size() / 6); // 3 for position + 3 for normal
+    glDrawElements(GL_TRIANGLES, GLsizei(meshVertices / 4 * 6), QuadIndices<Size>::TYPE, nullptr);
     glBindVertexArray(0);
 }
 
-Voxel* VoxelChunk::getVoxel(int x, int y, int z) {
-    if (x < 0 || x >= CHUNK_SIZE ||
-        y < 0 || y >= CHUNK_SIZE ||
-        z < 0 || z >= CHUNK_SIZE)
-        return nullptr;
-    return &voxels[x][y][z];
+template <int Size>
+Voxel BasicVoxelChunk<Size>::getVoxel(int x, int y, int z) const {
+    return voxels().getVoxel(x, y, z);
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::setVoxel(int x, int y, int z, const Voxel& voxel) {
+    if (!Voxels::contains(x, y, z))
+        return;
+
+    // Check first so that no-op writes do not clone published contents
+    MaterialId material = voxel.active ? voxel.material : MaterialId(MATERIAL_AIR);
+    if (voxels().getVoxel(x, y, z).material == material) return;
+    if (!edit().setVoxel(x, y, z, voxel)) return;
+
+    // The six neighbours' faces towards it changed too, and they may sit in other bricks
+    invalidateMesh(x + 1, y, z);
+    invalidateMesh(x - 1, y, z);
+    invalidateMesh(x, y + 1, z);
+    invalidateMesh(x, y - 1, z);
+    invalidateMesh(x, y, z + 1);
+    invalidateMesh(x, y, z - 1);
+}
+
+// Attributes stamp their brick like materials do, since the saver needs them;
+// the mesher then rebuilds that brick's section for nothing
+template <int Size>
+void BasicVoxelChunk<Size>::setLight(int x, int y, int z, LightLevel level) {
+    if (!Voxels::contains(x, y, z) || getLight(x, y, z) == level) return;
+    edit().setLight(x, y, z, level);
 }
+
+template <int Size>
+void BasicVoxelChunk<Size>::setDamage(int x, int y, int z, DamageLevel level) {
+    if (!isVoxelSolid(x, y, z) || getDamage(x, y, z) == level) return;
+    edit().setDamage(x, y, z, level);
+}
+
+template <int Size>
+std::size_t BasicVoxelChunk<Size>::memoryUsage() const {
+    // A pending draft and the published contents it was cloned from are both resident
+    std::size_t bytes = sizeof(BasicVoxelChunk) + head->memoryUsage() + (draft ? draft->memoryUsage() : 0);
+    if (sectionMesh)
+        for (const std::vector<ChunkVertex>& section : *sectionMesh) bytes += sizeof(section) + section.capacity() * sizeof(ChunkVertex);
+    if (seamQuads)
+        for (const std::vector<SeamQuad>& seams : *seamQuads) bytes += sizeof(seams) + seams.capacity() * sizeof(SeamQuad);
+    return bytes;
+}
+
+template <int Size>
+void BasicVoxelChunk<Size>::copyMesh(std::vector<ChunkVertex>& out) const {
+    out.clear();
+    if (!sectionMesh) return;
+    for (const std::vector<ChunkVertex>& section : *sectionMesh) out.insert(out.end(), section.begin(), section.end());
+}
+
+template class BasicVoxelChunk<16>;
+template class BasicVoxelChunk<32>;
+template class BasicVoxelChunk<64>;
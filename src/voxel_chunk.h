@@ -1,48 +1,187 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <glad/gl.h>
 #include <glm/glm.hpp>
-#include "voxel_utils.h"
-#include "shader.h" // 🔧 Add this in voxel_chunk.cpp
-#include <glm/gtc/type_ptr.hpp>
-#include<voxel_utils.h>
+#include "voxel.h"
+#include "chunk_voxels.h"
+#include "padded_occupancy.h"
+#include "shader.h"
 
 
 class Shader;
 class CubeRenderer;
 
-constexpr int CHUNK_SIZE = 16;
-
-enum class FaceDirection {
-    Right = 0,
-    Left,
-    Top,
-    Bottom,
-    Front,
-    Back
+enum class MeshMode {
+    Faces, // One quad per exposed voxel face
+    Greedy // Coplanar faces of one material merged into maximal rectangles
 };
 
-struct Voxel {
-    bool active = false;
-};
+// Chunk mesh vertices are one 32-bit word, unpacked by shaders/chunk.vert: a
+// voxel corner in chunk-local units, 7 bits per axis so that the 0..Size
+// corners of a 64^3 chunk fit (x in bits 0-6, y in 7-13, z in 14-20), and the
+// FaceDirection, which gives the normal, in bits 21-23
+using ChunkVertex = std::uint32_t;
 
-class VoxelChunk {
+constexpr ChunkVertex packChunkVertex(int x, int y, int z, FaceDirection dir) {
+    return ChunkVertex(x) | ChunkVertex(y) << 7 | ChunkVertex(z) << 14 | ChunkVertex(dir) << 21;
+}
+
+// A chunk's render state plus copy-on-write voxel contents. Published contents
+// are immutable: the first edit after a publish clones them into a private
+// draft, further edits go to the draft, and publish() swaps it in atomically.
+// Any thread may take a snapshot() without locking; everything else, including
+// reads through getVoxel (which see unpublished edits), belongs to the writer.
+//
+// Mesh and save state are version stamps against the contents' BrickVersions:
+// the mesh is kept per section (the 4x4 rows of one column of bricks, plus in
+// greedy mode one seam section per axis and 4-slice slab), and updateMesh
+// rebuilds only the sections with bricks changed since it last ran.
+//
+// Templated on the chunk edge (instantiated for 16, 32 and 64 in
+// voxel_chunk.cpp); the world uses VoxelChunk, the CHUNK_SIZE edition.
+template <int Size>
+class BasicVoxelChunk {
 public:
-    VoxelChunk();
+    using Dims = ChunkDims<Size>;
+    using Voxels = BasicChunkVoxels<Size>;
+    using Row = OccupancyRowFor<Size>;
+    using Neighbours = typename PaddedOccupancy<Size>::Neighbours;
+    using Versions = BrickVersions<Size>;
+    using BrickMask = typename Versions::Mask;
+
+    explicit BasicVoxelChunk(const glm::ivec3& chunkPos = glm::ivec3(0));
+    ~BasicVoxelChunk();
 
-    void generateTerrainChunk(const glm::ivec3& chunkPos, int maxHeight);
-    void updateMesh();
+    // Owns GL handles, so chunks are not copyable
+    BasicVoxelChunk(const BasicVoxelChunk&) = delete;
+    BasicVoxelChunk& operator=(const BasicVoxelChunk&) = delete;
+
+    // Empties the chunk for reuse at another position; only its GL handles are kept
+    void reset(const glm::ivec3& newChunkPos);
+    void generateTerrainChunk(int maxHeight);
+    void fill(const Voxel& voxel);
+    void setColumnRuns(int x, int z, std::span<const VoxelRun> runs);
+    bool compactColumns();
+    // Faces against a solid neighbour are culled; leave an entry null where the
+    // neighbour is unknown and the border faces are kept. buildMesh rebuilds
+    // every section, refreshMesh only stale ones (all of them if the mode
+    // changed); updateMesh refreshes and uploads. Greedy quads crossing sections
+    // are merged again per slab, only in the slabs whose seam quads an edit
+    // changed (at most one per axis, often none).
+    void buildMesh(const Neighbours& neighbours = {}, MeshMode mode = MeshMode::Faces);
+    void refreshMesh(const Neighbours& neighbours = {}, MeshMode mode = MeshMode::Faces);
+    void updateMesh(const Neighbours& neighbours = {}, MeshMode mode = MeshMode::Faces);
     void uploadMesh();
     void draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj);
-    Voxel* getVoxel(int x, int y, int z);
-    bool dirty = true;
+    Voxel getVoxel(int x, int y, int z) const;
+    void setVoxel(int x, int y, int z, const Voxel& voxel);
+    bool isVoxelSolid(int x, int y, int z) const;
+    LightLevel getLight(int x, int y, int z) const { return voxels().getLight(x, y, z); }
+    void setLight(int x, int y, int z, LightLevel level);
+    DamageLevel getDamage(int x, int y, int z) const { return voxels().getDamage(x, y, z); }
+    void setDamage(int x, int y, int z, DamageLevel level);
+    const glm::ivec3& getChunkPos() const { return chunkPos; }
+    const PaletteStorage& getMaterials() const { return voxels().getMaterials(); }
+    bool isUniform() const { return voxels().isUniform(); }
+    ChunkStorage getStorage() const { return voxels().getStorage(); }
+    // Vertices in the last built mesh, four per quad; draw() issues one indexed
+    // call if this is non-zero. Draw with a shader built on shaders/chunk.vert,
+    // which unpacks ChunkVertex
+    std::size_t meshVertexCount() const { return meshVertices; }
+    // The last built mesh, sections back to back as uploadMesh sends them
+    void copyMesh(std::vector<ChunkVertex>& out) const;
+    std::size_t memoryUsage() const;
+    std::uint64_t lastAccess = 0; // Frame stamp, see ChunkResidency
+
+    // Bricks whose faces may be out of date: changed since the mesh was built,
+    // or invalidated because a neighbour changed next to them
+    BrickMask staleBricks() const { return voxels().getVersions().changedSince(meshedVersion) | invalidBricks; }
+    bool isMeshStale() const { return staleBricks().any(); }
+    MeshMode getMeshMode() const { return meshedMode; }
+    void invalidateMesh() { invalidBricks.set(); }
+    // Just the brick holding local voxel (x, y, z)
+    void invalidateMesh(int x, int y, int z);
+    // The bricks along one face, after the neighbour beyond it appeared or went away
+    void invalidateBorder(FaceDirection dir);
+
+    // Edited since it was generated, loaded or last saved; generators and loaders
+    // call markRebuilt and then markSaved once the contents match what they can
+    // reproduce. markRebuilt counts every brick as changed (a new chunk's mesh is
+    // all stale anyway), so the contents need not keep per-brick stamps.
+    bool isUnsaved() const { return voxels().getVersions().getVersion() != savedVersion; }
+    BrickMask unsavedBricks() const { return voxels().getVersions().changedSince(savedVersion); }
+    void markRebuilt() { edit().markRebuilt(); stored = false; }
+    void markSaved() { savedVersion = voxels().getVersions().getVersion(); }
+    // Saved, and the ChunkStore file is what it was saved or loaded from, so the
+    // next save may append unsavedBricks() to it (see ChunkStore::saveBricks)
+    bool isStored() const { return stored; }
+    void markStored() { markSaved(); stored = true; }
+
+    // Latest contents including unpublished edits (writer only)
+    const Voxels& voxels() const { return draft ? *draft : *head; }
+    // Last published contents; safe from any thread and stays valid while held
+    std::shared_ptr<const Voxels> snapshot() const { return published.load(std::memory_order_acquire); }
+    // Makes pending edits visible to snapshot(); a no-op without any
+    void publish();
+    bool hasUnpublishedEdits() const { return draft != nullptr; }
 
 private:
-    Voxel voxels[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
-    std::vector<float> meshData;
-    GLuint VAO = 0, VBO = 0;
+    std::atomic<std::shared_ptr<const Voxels>> published;
+    std::shared_ptr<const Voxels> head; // Writer's copy of the published pointer, read without atomics
+    std::shared_ptr<Voxels> draft;      // Private clone of head, only while edits are pending
+    // Vertices per section: section (bx * BRICKS + by) holds the faces of rows x
+    // in [4bx, 4bx+4), y in [4by, 4by+4). Greedy mode merges quads within those
+    // rows and sets aside the ones touching their edge inside the chunk as seam
+    // quads; the SEAM_SLABS sections after them, (axis * BRICKS + slab), hold the
+    // seam quads along that axis of slices [4slab, 4slab+4) merged again across
+    // the whole slice. Allocated by the first mesh with any faces, so chunks never
+    // meshed (or with nothing to show) carry a pointer rather than empty vectors.
+    static constexpr int SECTIONS = Versions::BRICKS * Versions::BRICKS;
+    static constexpr int SEAM_SLABS = 3 * Versions::BRICKS;
+    using SectionMeshes = std::array<std::vector<ChunkVertex>, SECTIONS + SEAM_SLABS>;
+    std::unique_ptr<SectionMeshes> sectionMesh;
+    // A greedy quad left for its seam slab, in the slice's (u, v) coordinates (see meshGreedy)
+    struct SeamQuad {
+        std::uint8_t dir, slice, u, v, height, width;
+        MaterialId material;
 
-    bool isVoxelSolid(int x, int y, int z) const;
-    void appendFace(FaceDirection dir, const glm::vec3& pos);
+        int slab() const { return dir / 2 * Versions::BRICKS + slice / Versions::BRICK; }
+        bool operator==(const SeamQuad&) const = default;
+    };
+    // Per section, greedy mode only
+    using SeamQuads = std::array<std::vector<SeamQuad>, SECTIONS>;
+    std::unique_ptr<SeamQuads> seamQuads;
+    std::size_t meshVertices = 0;
+    std::uint32_t meshedVersion = 0;
+    MeshMode meshedMode = MeshMode::Faces;
+    BrickMask invalidBricks;
+    std::uint32_t savedVersion = 0;
+    bool stored = false;
+    glm::ivec3 chunkPos;
+    GLuint VAO = 0, VBO = 0; // Created lazily on first upload
+
+    Voxels& edit();
+    void rebuildSections(const Neighbours& neighbours, const BrickMask& stale, MeshMode mode);
+    void meshRows(const PaddedOccupancy<Size>& padded, int section);
+    using SlabMask = std::bitset<SEAM_SLABS>;
+    // Adds the seam slabs whose quads from this section changed to `changed`
+    void meshGreedy(const PaddedOccupancy<Size>& padded, int section, SlabMask& changed);
+    void mergeSeams(const SlabMask& slabs);
+    void releaseGlObjects();
+    void appendFaces(std::vector<ChunkVertex>& out, FaceDirection dir, Row faces, int x, int y);
+    // A face of the voxels from pos to pos + size - 1 (size is 1 along the normal)
+    void appendQuad(std::vector<ChunkVertex>& out, FaceDirection dir, const glm::ivec3& pos, const glm::ivec3& size);
+};
+
+// A class rather than an alias so that other headers can forward-declare it
+class VoxelChunk : public BasicVoxelChunk<CHUNK_SIZE> {
+public:
+    using BasicVoxelChunk::BasicVoxelChunk;
 };
@@ -1,13 +1,71 @@
 // voxel_utils.h
 
 #pragma once
+#include <bit>
+#include <cstdint>
 #include <glm/glm.hpp>
 
-inline glm::ivec3 toChunkPos(const glm::ivec3& voxelPos) {
-    return voxelPos / 16;
+// Edge length of the world's chunks; templates below default to it
+constexpr int CHUNK_SIZE = 16;
+
+// Compile-time shift/mask arithmetic for a power-of-two chunk edge
+template <int Size>
+struct ChunkDims {
+    static_assert(Size >= 8 && Size <= 64 && (Size & (Size - 1)) == 0,
+                  "chunk edge must be a power of two between 8 and 64");
+    static constexpr int SIZE = Size;
+    static constexpr int SHIFT = std::countr_zero(unsigned(Size));
+    static constexpr int MASK = Size - 1;
+    static constexpr int AREA = Size * Size;
+    static constexpr int VOLUME = Size * Size * Size;
+};
+
+template <int Size = CHUNK_SIZE>
+glm::ivec3 toChunkPos(const glm::ivec3& voxelPos) {
+    // Arithmetic shift floors towards -inf, so voxel -1 lands in chunk -1
+    // (plain division truncates it into chunk 0 and disagrees with toLocalPos)
+    constexpr int shift = ChunkDims<Size>::SHIFT;
+    return glm::ivec3(voxelPos.x >> shift, voxelPos.y >> shift, voxelPos.z >> shift);
+}
+
+template <int Size = CHUNK_SIZE>
+glm::ivec3 toLocalPos(const glm::ivec3& voxelPos) {
+    // Two's complement masking is a floor modulo, matching toChunkPos
+    constexpr int mask = ChunkDims<Size>::MASK;
+    return glm::ivec3(voxelPos.x & mask, voxelPos.y & mask, voxelPos.z & mask);
+}
+
+// --- Morton (Z-order) codes: 21 bits per axis, signed coords biased by 2^20 ---
+constexpr std::uint64_t mortonSpread(std::uint64_t v) {
+    v &= 0x1FFFFF;
+    v = (v | v << 32) & 0x1F00000000FFFFull;
+    v = (v | v << 16) & 0x1F0000FF0000FFull;
+    v = (v | v << 8) & 0x100F00F00F00F00Full;
+    v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+constexpr std::uint64_t mortonCompact(std::uint64_t v) {
+    v &= 0x1249249249249249ull;
+    v = (v ^ (v >> 2)) & 0x10C30C30C30C30C3ull;
+    v = (v ^ (v >> 4)) & 0x100F00F00F00F00Full;
+    v = (v ^ (v >> 8)) & 0x1F0000FF0000FFull;
+    v = (v ^ (v >> 16)) & 0x1F00000000FFFFull;
+    v = (v ^ (v >> 32)) & 0x1FFFFF;
+    return v;
+}
+
+inline std::uint64_t mortonEncode(const glm::ivec3& pos) {
+    constexpr int bias = 1 << 20;
+    return mortonSpread(std::uint64_t(pos.x + bias)) |
+           mortonSpread(std::uint64_t(pos.y + bias)) << 1 |
+           mortonSpread(std::uint64_t(pos.z + bias)) << 2;
 }
 
-inline glm::ivec3 toLocalPos(const glm::ivec3& voxelPos) {
-    glm::ivec3 pos = voxelPos % 16;
-    return glm::ivec3((pos.x + 16) % 16, (pos.y + 16) % 16, (pos.z + 16) % 16);
+inline glm::ivec3 mortonDecode(std::uint64_t code) {
+    constexpr int bias = 1 << 20;
+    return glm::ivec3(int(mortonCompact(code)) - bias,
+                      int(mortonCompact(code >> 1)) - bias,
+                      int(mortonCompact(code >> 2)) - bias);
 }
@@ -1,6 +1,7 @@
     #define STB_PERLIN_IMPLEMENTATION
     #include <stb_perlin.h>
     #include <algorithm>
+    #include <limits>
 
     #include "voxel_world.h"
     #include "voxel_utils.h"
@@ -13,104 +14,364 @@
     #include <glm/gtc/matrix_transform.hpp>
 
     // --- Frustum culling helper ---
-    bool isCubeInFrustum(const glm::vec3& pos, const glm::mat4& VP) {
-        const float half = 0.5f;
-        glm::vec3 offsets[] = {
-            {-half, -half, -half}, { half, -half, -half},
-            {-half,  half, -half}, { half,  half, -half},
-            {-half, -half,  half}, { half, -half,  half},
-            {-half,  half,  half}, { half,  half,  half}
-        };
+    // Tests an AABB against the six clip planes of VP. Checking corners alone would
+    // drop a chunk the camera is standing inside, since all its corners lie off-screen.
+    bool isBoxInFrustum(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& VP) {
+        for (int i = 0; i < 6; ++i) {
+            int row = i / 2;
+            float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+            glm::vec4 plane(
+                VP[0][3] + sign * VP[0][row],
+                VP[1][3] + sign * VP[1][row],
+                VP[2][3] + sign * VP[2][row],
+                VP[3][3] + sign * VP[3][row]);
 
-        for (const auto& offset : offsets) {
-            glm::vec4 clip = VP * glm::vec4(pos + offset, 1.0f);
-            if (clip.w == 0.0f) continue;
-            clip /= clip.w;
+            // Corner furthest along the plane normal
+            glm::vec3 p(
+                plane.x > 0.0f ? boxMax.x : boxMin.x,
+                plane.y > 0.0f ? boxMax.y : boxMin.y,
+                plane.z > 0.0f ? boxMax.z : boxMin.z);
 
-            if (clip.x >= -1 && clip.x <= 1 &&
-                clip.y >= -1 && clip.y <= 1 &&
-                clip.z >= -1 && clip.z <= 1) {
-                return true;
-            }
+            if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f)
+                return false;
         }
+        return true;
+    }
 
-        return false;
+    VoxelChunk* VoxelWorld::getChunk(const glm::ivec3& chunkPos) const {
+        return chunks.get(chunkPos);
     }
 
-    void VoxelWorld::generateTerrain(int width, int depth, int maxHeight) {
+    VoxelChunk& VoxelWorld::getOrCreateChunk(const glm::ivec3& chunkPos) {
+        bool created = false;
+        VoxelChunk& chunk = chunks.getOrCreate(chunkPos, [&] {
+            created = true;
+            return chunkPool.acquire(chunkPos);
+        });
+        // Outside the directory's lock, since it looks the neighbours up
+        if (created) invalidateNeighbourBorders(chunkPos);
+        return chunk;
+    }
+
+    // Face neighbour offsets in FaceDirection order
+    static const glm::ivec3 faceOffsets[6] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+    };
+
+    // Stand-in for evicted neighbours under UnloadedNeighbours::Solid; uniform, so no per-voxel data
+    const ChunkVoxels& solidNeighbour() {
+        static const ChunkVoxels solid = [] {
+            ChunkVoxels voxels;
+            voxels.fill(Voxel{ true, MATERIAL_STONE });
+            return voxels;
+        }();
+        return solid;
+    }
+
+    VoxelChunk::Neighbours VoxelWorld::neighboursOf(const glm::ivec3& chunkPos) const {
+        VoxelChunk::Neighbours neighbours{};
+        for (int dir = 0; dir < 6; ++dir) {
+            glm::ivec3 neighbourPos = chunkPos + faceOffsets[dir];
+            if (VoxelChunk* chunk = getChunk(neighbourPos))
+                neighbours[dir] = &chunk->voxels();
+            else if (unloadedNeighbours == UnloadedNeighbours::Solid && residency.isEvicted(neighbourPos))
+                neighbours[dir] = &solidNeighbour();
+        }
+        return neighbours;
+    }
+
+    void VoxelWorld::invalidateNeighbourBorders(const glm::ivec3& chunkPos) {
+        // The neighbour at faceOffsets[dir] faces back with the opposite direction
+        for (int dir = 0; dir < 6; ++dir)
+            if (VoxelChunk* neighbour = getChunk(chunkPos + faceOffsets[dir]))
+                neighbour->invalidateBorder(FaceDirection(dir ^ 1));
+    }
+
+    bool VoxelWorld::unloadChunk(const glm::ivec3& chunkPos) {
+        if (!chunks.erase(chunkPos)) return false;
+        invalidateNeighbourBorders(chunkPos);
+        return true;
+    }
+
+    // Clips a bottom-up run list to [yBegin, yEnd), rebased so yBegin becomes 0
+    int sliceRuns(const VoxelRun* runs, int count, int yBegin, int yEnd, VoxelRun* out) {
+        int n = 0, y = 0;
+        for (int i = 0; i < count; ++i) {
+            int from = std::max(y, yBegin), to = std::min(y + runs[i].length, yEnd);
+            if (from < to) out[n++] = { runs[i].material, to - from };
+            y += runs[i].length;
+        }
+        return n;
+    }
+
+    // Surface height of world column (x, z); pure, so regenerating a chunk reproduces it
+    int VoxelWorld::terrainHeight(int x, int z) const {
         float scale = 0.1f; // Smaller = smoother terrain
-        for (int x = -width / 2; x < width / 2; ++x) {
-            for (int z = -depth / 2; z < depth / 2; ++z) {
-                float noise = stb_perlin_noise3(x * scale, 0.0f, z * scale, 0, 0, 0);
-                int height = static_cast<int>((noise + 1.0f) / 2.0f * maxHeight); // Normalize
+        float noise = stb_perlin_noise3(x * scale, 0.0f, z * scale, 0, 0, 0);
+        return static_cast<int>((noise + 1.0f) / 2.0f * terrainMaxHeight); // Normalize
+    }
 
-                for (int y = 0; y <= height; ++y) {
-                    voxels[{x, y, z}] = Voxel{};
-                }
+    void VoxelWorld::generateTerrain(int width, int depth, int maxHeight) {
+        terrainWidth = width;
+        terrainDepth = depth;
+        terrainMaxHeight = maxHeight;
+
+        glm::ivec3 minChunk = toChunkPos(glm::ivec3(-width / 2, 0, -depth / 2));
+        glm::ivec3 maxChunk = toChunkPos(glm::ivec3(width / 2 - 1, maxHeight, depth / 2 - 1));
+        for (int cx = minChunk.x; cx <= maxChunk.x; ++cx)
+            for (int cz = minChunk.z; cz <= maxChunk.z; ++cz)
+                for (int cy = 0; cy <= maxChunk.y; ++cy)
+                    generateChunk(glm::ivec3(cx, cy, cz));
+    }
+
+    VoxelChunk* VoxelWorld::generateChunk(const glm::ivec3& chunkPos) {
+        glm::ivec3 origin = chunkPos * CHUNK_SIZE;
+        if (origin.y < 0) return nullptr;
+
+        // Column heights inside the terrain bounds, -1 outside
+        int heights[CHUNK_SIZE][CHUNK_SIZE];
+        int top = -1;
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                int wx = origin.x + x, wz = origin.z + z;
+                bool inside = wx >= -terrainWidth / 2 && wx < terrainWidth / 2 &&
+                              wz >= -terrainDepth / 2 && wz < terrainDepth / 2;
+                heights[x][z] = inside ? terrainHeight(wx, wz) : -1;
+                top = std::max(top, heights[x][z]);
+            }
+        }
+        bool edited = !edits.find(chunkPos).empty();
+        if (top < origin.y && !edited) return nullptr;
+
+        VoxelChunk& chunk = getOrCreateChunk(chunkPos);
+        if (columnStorage) chunk.compactColumns();
+
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                int height = heights[x][z];
+                if (height < origin.y) continue;
+
+                // Grass cap, a few blocks of dirt, stone below: y = 0..height as runs
+                int stone = std::max(height - 3, 0);
+                VoxelRun column[3] = {
+                    { MATERIAL_STONE, stone },
+                    { MATERIAL_DIRT, height - stone },
+                    { MATERIAL_GRASS, 1 }
+                };
+
+                // This chunk's slice of the column
+                VoxelRun slice[3];
+                int count = sliceRuns(column, 3, origin.y, origin.y + CHUNK_SIZE, slice);
+                chunk.setColumnRuns(x, z, std::span<const VoxelRun>(slice, count));
             }
         }
+
+        // Reproducible from the settings and the overlay, so nothing to save
+        if (edited) edits.apply(chunk);
+        chunk.markRebuilt();
+        chunk.markSaved();
+
+        // Built in one draft, handed to readers in one swap
+        chunk.publish();
+        return &chunk;
     }
     void VoxelWorld::deactivateVoxel(const glm::ivec3& worldPos) {
-        auto it = voxels.find({worldPos.x, worldPos.y, worldPos.z});
-        if (it != voxels.end() && it->second.active) {
-            it->second.active = false;
+        glm::ivec3 chunkPos = toChunkPos(worldPos);
+        VoxelChunk* chunk = loadChunk(chunkPos);
+        if (!chunk && isFrozen(ChunkPool::regionOf(chunkPos))) {
+            thawRegion(ChunkPool::regionOf(chunkPos));
+            chunk = loadChunk(chunkPos);
+        }
+        if (!chunk) return;
+
+        glm::ivec3 local = toLocalPos(worldPos);
+        bool wasSaved = !chunk->isUnsaved();
+        chunk->setVoxel(local.x, local.y, local.z, Voxel{ false });
+        chunk->publish();
+        if (overlayStorage) {
+            // The overlay keeps the edit, so the chunk needs no save of its own for it
+            edits.set(worldPos, MATERIAL_AIR);
+            if (wasSaved) chunk->markSaved();
+        }
+
+        // Meshes cull against their neighbours, so a border voxel's neighbour may now show a face
+        for (int axis = 0; axis < 3; ++axis) {
+            glm::ivec3 step(0);
+            if (local[axis] == 0) step[axis] = -1;
+            else if (local[axis] == CHUNK_SIZE - 1) step[axis] = 1;
+            else continue;
+            if (VoxelChunk* neighbour = getChunk(chunk->getChunkPos() + step)) {
+                glm::ivec3 across = toLocalPos(worldPos + step);
+                neighbour->invalidateMesh(across.x, across.y, across.z);
+            }
         }
     }
 
-    Voxel* VoxelWorld::getVoxel(const glm::ivec3& worldPos) {
-        auto it = voxels.find({worldPos.x, worldPos.y, worldPos.z});
-        if (it == voxels.end()) return nullptr;
-        return &(it->second);
+    std::optional<Voxel> VoxelWorld::getVoxel(const glm::ivec3& worldPos) {
+        glm::ivec3 chunkPos = toChunkPos(worldPos);
+        VoxelChunk* chunk = loadChunk(chunkPos);
+        if (!chunk) {
+            if (const auto* frozen = frozenRegions.find(ChunkPool::regionOf(chunkPos)))
+                return (*frozen)->dag.getVoxel(worldPos);
+            return std::nullopt;
+        }
+
+        glm::ivec3 local = toLocalPos(worldPos);
+        return chunk->getVoxel(local.x, local.y, local.z);
     }
 
 
 
-    void VoxelWorld::draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj) const {
-        glm::vec3 cameraPos = glm::vec3(glm::inverse(viewProj)[3]); // Extract approximate camera position
+    std::optional<RayHit> VoxelWorld::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+        // Voxel v spans v - 0.5 to v + 0.5; shifted by half a voxel, cells start on integers
+        glm::vec3 start = origin + glm::vec3(0.5f);
+        glm::ivec3 normal(0);
+        float t = 0.0f;
+        // Steps within one chunk look it up (and count an access) only once
+        glm::ivec3 lastChunkPos(0);
+        VoxelChunk* lastChunk = nullptr;
+        bool looked = false;
+        while (t <= maxDistance) {
+            glm::ivec3 voxel(glm::floor(start + direction * t));
+            int cell = CHUNK_SIZE; // A missing chunk is all air
+            glm::ivec3 chunkPos = toChunkPos(voxel);
+            if (!looked || chunkPos != lastChunkPos) {
+                lastChunk = loadChunk(chunkPos);
+                lastChunkPos = chunkPos;
+                looked = true;
+            }
+            if (VoxelChunk* chunk = lastChunk) {
+                glm::ivec3 local = toLocalPos(voxel);
+                cell = chunk->voxels().getSummary().emptyCell(local.x, local.y, local.z);
+                if (cell == 0) {
+                    if (chunk->isVoxelSolid(local.x, local.y, local.z)) return RayHit{ voxel, normal, t };
+                    cell = 1;
+                }
+            } else if (const auto* frozen = frozenRegions.find(ChunkPool::regionOf(chunkPos))) {
+                // Frozen regions have no summary; step them voxel by voxel
+                if ((*frozen)->dag.getVoxel(voxel)->active) return RayHit{ voxel, normal, t };
+                cell = 1;
+            }
 
-        std::vector<std::pair<float, const VoxelPos*>> visibleVoxels;
+            // Jump to where the ray leaves the aligned empty cell (cells are powers of two)
+            float exit = std::numeric_limits<float>::infinity();
+            int exitAxis = 0;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (direction[axis] == 0.0f) continue;
+                int low = voxel[axis] & ~(cell - 1);
+                float bound = float(direction[axis] > 0.0f ? low + cell : low);
+                float tAxis = (bound - start[axis]) / direction[axis];
+                if (tAxis < exit) { exit = tAxis; exitAxis = axis; }
+            }
+            normal = glm::ivec3(0);
+            normal[exitAxis] = direction[exitAxis] > 0.0f ? -1 : 1;
+            t = std::max(exit, t) + 1e-4f; // Nudged across the boundary
+        }
+        return std::nullopt;
+    }
+
+    std::size_t VoxelWorld::freezeRegion(const glm::ivec3& regionPos) {
+        if (isFrozen(regionPos)) return 0;
+        auto frozen = std::make_unique<FrozenRegion>(FrozenRegion{ SparseVoxelDag(chunkPool, regionPos), {} });
 
-        for (const auto& [pos, voxel] : voxels) {
-            if (!voxel.active) continue;
+        // Collected first: unloading must not happen under the pool lock
+        std::vector<VoxelChunk*> regionChunks;
+        chunkPool.forEachChunkInRegion(regionPos, [&](VoxelChunk& chunk) { regionChunks.push_back(&chunk); });
 
-            glm::vec3 worldPos = glm::vec3(pos.x, pos.y, pos.z);
+        std::size_t count = 0;
+        constexpr int EDGE = ChunkPool::REGION_EDGE;
+        glm::ivec3 origin = regionPos * EDGE;
+        for (VoxelChunk* chunk : regionChunks) {
+            const ChunkVoxels& voxels = chunk->voxels();
+            if (voxels.getLightChannel().isAllocated() || voxels.getDamageChannel().isAllocated()) continue;
+            glm::ivec3 c = chunk->getChunkPos() - origin;
+            frozen->unsaved[(c.x * EDGE + c.y) * EDGE + c.z] = chunk->isUnsaved();
+            unloadChunk(chunk->getChunkPos());
+            ++count;
+        }
+        frozenRegions[regionPos] = std::move(frozen);
+        return count;
+    }
 
-            // Distance culling
-            float distSq = glm::dot(worldPos - cameraPos, worldPos - cameraPos);
-            if (distSq > 400.0f * 400.0f) continue;  // Skip far voxels (e.g. >200 units)
+    std::size_t VoxelWorld::thawRegion(const glm::ivec3& regionPos) {
+        std::unique_ptr<FrozenRegion>* slot = frozenRegions.find(regionPos);
+        if (!slot) return 0;
+        std::unique_ptr<FrozenRegion> frozen = std::move(*slot);
+        frozenRegions.erase(regionPos);
 
-            // Skip fully surrounded blocks (face culling)
-            VoxelPos neighbors[6] = {
-                {pos.x + 1, pos.y, pos.z}, {pos.x - 1, pos.y, pos.z},
-                {pos.x, pos.y + 1, pos.z}, {pos.x, pos.y - 1, pos.z},
-                {pos.x, pos.y, pos.z + 1}, {pos.x, pos.y, pos.z - 1}
-            };
+        std::size_t count = 0;
+        std::vector<MaterialId> materials;
+        std::vector<VoxelRun> runs;
+        constexpr int EDGE = ChunkPool::REGION_EDGE;
+        glm::ivec3 origin = regionPos * EDGE;
+        for (int i = 0; i < ChunkPool::REGION_CHUNKS; ++i) {
+            glm::ivec3 chunkPos = origin + glm::ivec3(i / (EDGE * EDGE), i / EDGE % EDGE, i % EDGE);
+            // Chunks left loaded (or evicted since) are newer than the DAG
+            if (getChunk(chunkPos) || residency.isEvicted(chunkPos)) continue;
+            if (!frozen->dag.decodeCube(chunkPos * CHUNK_SIZE, ChunkDims<CHUNK_SIZE>::SHIFT, materials)) continue;
 
-            bool hasVisibleFace = false;
-            for (const auto& n : neighbors) {
-                auto it = voxels.find(n);
-                if (it == voxels.end() || !it->second.active) {
-                    hasVisibleFace = true;
-                    break;
+            VoxelChunk& chunk = getOrCreateChunk(chunkPos);
+            if (columnStorage) chunk.compactColumns();
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    runs.clear();
+                    for (int y = 0; y < CHUNK_SIZE; ++y) {
+                        MaterialId material = materials[(x * CHUNK_SIZE + y) * CHUNK_SIZE + z];
+                        if (!runs.empty() && runs.back().material == material) ++runs.back().length;
+                        else runs.push_back({ material, 1 });
+                    }
+                    chunk.setColumnRuns(x, z, runs);
                 }
             }
-            if (!hasVisibleFace) continue;
+            chunk.markRebuilt();
+            if (!frozen->unsaved[i]) chunk.markSaved();
+            chunk.publish();
+            ++count;
+        }
+        return count;
+    }
+
+    void VoxelWorld::draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj) {
+        glm::vec3 cameraPos = glm::vec3(glm::inverse(viewProj)[3]); // Extract approximate camera position
+
+        auto isVisible = [&](const glm::ivec3& chunkPos) {
+            glm::vec3 chunkMin = glm::vec3(chunkPos * CHUNK_SIZE) - glm::vec3(0.5f);
+            glm::vec3 chunkMax = chunkMin + glm::vec3(float(CHUNK_SIZE));
+            glm::vec3 center = (chunkMin + chunkMax) * 0.5f;
+
+            // Distance culling, padded by the chunk's half diagonal
+            float reach = 400.0f + CHUNK_SIZE * 0.87f;
+            float distSq = glm::dot(center - cameraPos, center - cameraPos);
+            if (distSq > reach * reach) return false;
 
             // Frustum culling
-            if (!isCubeInFrustum(worldPos, viewProj)) continue;
+            return isBoxInFrustum(chunkMin, chunkMax, viewProj);
+        };
 
-            visibleVoxels.emplace_back(distSq, &pos);
-        }
+        // Walked region by region so chunk headers stream from memory. Collected
+        // first: meshing looks up neighbours, which must not happen under the
+        // pool lock, and restored chunks should be seen by theirs
+        std::vector<VoxelChunk*> visible;
+        chunkPool.forEachChunk([&](VoxelChunk& chunk) {
+            if (!isVisible(chunk.getChunkPos())) return;
+            residency.touch(chunk);
+            visible.push_back(&chunk);
+        });
 
-        // Sort for transparency/farther-to-closer (optional)
-        std::sort(visibleVoxels.begin(), visibleVoxels.end(),
-                [](const auto& a, const auto& b) { return a.first > b.first; });
+        // Evicted chunks that came back into view (restoring inserts into chunks, so not above)
+        std::vector<glm::ivec3> restore;
+        for (const auto& [key, unused] : residency.getEvicted()) {
+            glm::ivec3 chunkPos = mortonDecode(key);
+            if (isVisible(chunkPos)) restore.push_back(chunkPos);
+        }
+        for (const glm::ivec3& chunkPos : restore)
+            if (VoxelChunk* chunk = loadChunk(chunkPos)) visible.push_back(chunk);
 
-        for (const auto& [_, posPtr] : visibleVoxels) {
-            glm::vec3 worldPos = glm::vec3(posPtr->x, posPtr->y, posPtr->z);
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
-            shader.setMat4("model", &model[0][0]);
-            renderer.draw(shader);
+        for (VoxelChunk* chunk : visible) {
+            // Remesh lazily, only chunks that are actually about to be drawn
+            if (chunk->isMeshStale() || chunk->getMeshMode() != meshMode)
+                chunk->updateMesh(neighboursOf(chunk->getChunkPos()), meshMode);
+            chunk->draw(renderer, shader, viewProj);
         }
     }
 
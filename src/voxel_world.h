@@ -2,40 +2,113 @@
 #define VOXEL_WORLD_H
 
 #include <glm/glm.hpp>
-#include <unordered_map>
+#include <bitset>
+#include <memory>
+#include <optional>
 #include "cube_renderer.h"
 #include "shader.h"
+#include "voxel.h"
+#include "voxel_chunk.h"
+#include "chunk_pool.h"
+#include "chunk_directory.h"
+#include "chunk_residency.h"
+#include "chunk_store.h"
+#include "edit_overlay.h"
+#include "sparse_voxel_dag.h"
 
-struct Voxel {
-    bool active = true;
-    // You can later add: material, type, etc.
-    
-};
-
-struct VoxelPos {
-    int x, y, z;
-
-    bool operator==(const VoxelPos& other) const {
-        return x == other.x && y == other.y && z == other.z;
-    }
-};
-
-struct VoxelHash {
-    std::size_t operator()(const VoxelPos& pos) const {
-        return std::hash<int>()(pos.x) ^ std::hash<int>()(pos.y << 1) ^ std::hash<int>()(pos.z << 2);
-    }
+struct RayHit {
+    glm::ivec3 voxel;  // First solid voxel along the ray
+    glm::ivec3 normal; // Face the ray entered it through; zero if it started inside
+    float distance;
 };
 
 class VoxelWorld {
 public:
-    std::unordered_map<VoxelPos, Voxel, VoxelHash> voxels;
+    // Backs every chunk below; declared first so it outlives the handles
+    ChunkPool chunkPool;
+    // 16^3 blocks keyed by chunk coordinate (see toChunkPos/toLocalPos); safe to
+    // look up and create from any thread
+    ChunkDirectory chunks;
+    // Keep generated chunks as RLE columns until they are first edited
+    bool columnStorage = false;
+    // How draw meshes chunks; changing it remeshes every chunk as it is next drawn
+    MeshMode meshMode = MeshMode::Faces;
+    // How chunk borders facing an evicted neighbour are meshed: as if it were solid
+    // (its faces culled; a hole shows there until the neighbour is back, which
+    // happens as soon as it comes into view) or air (every border face kept).
+    // Chunks that were never generated are empty and always count as air.
+    enum class UnloadedNeighbours { Solid, Air };
+    UnloadedNeighbours unloadedNeighbours = UnloadedNeighbours::Solid;
+    // Memory budget and LRU eviction; set residency.budgetBytes to enable
+    ChunkResidency residency;
+    // Where edited chunks are saved before eviction; without one they stay resident
+    std::unique_ptr<ChunkStore> chunkStore;
+    // Record world edits (deactivateVoxel) in `edits` rather than only in the chunk:
+    // an edited chunk is then as cheap to evict as an untouched one, since
+    // generateChunk rebuilds it from the terrain plus its edits, and only the
+    // overlay is ever saved. Edits made directly on a chunk are saved whole as before.
+    bool overlayStorage = false;
+    EditOverlay edits;
+    // The overlay to/from chunkStore; false without a store or on failure.
+    // Load before generateTerrain so the generated chunks include the edits
+    bool saveEdits() const { return chunkStore && chunkStore->saveOverlay(edits); }
+    bool loadEdits() { return chunkStore && chunkStore->loadOverlay(edits); }
     void deactivateVoxel(const glm::ivec3& worldPos);
-    Voxel* getVoxel(const glm::ivec3& worldPos);
+    // Restores the chunk if it was evicted, hence not const
+    std::optional<Voxel> getVoxel(const glm::ivec3& worldPos);
+    // First solid voxel within maxDistance along a normalized direction. Steps
+    // over missing chunks and empty blocks/bricks (see OccupancySummary) whole.
+    std::optional<RayHit> raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
     void generateFlatGround(int width, int depth);
-   void draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj) const;
+   void draw(CubeRenderer& renderer, Shader& shader, const glm::mat4& viewProj);
    void generateTerrain(int width, int depth, int maxHeight);
- 
+    // (Re)generates one chunk from the last generateTerrain settings plus its
+    // overlay edits; nullptr if it would be empty
+    VoxelChunk* generateChunk(const glm::ivec3& chunkPos);
+    // Call once per frame: evicts least recently used chunks down to the residency budget
+    void trimToBudget() { residency.trim(*this); }
+    // Whole ChunkPool regions (REGION_EDGE^3 chunks) at once, see ChunkResidency
+    std::size_t saveRegion(const glm::ivec3& regionPos) { return residency.saveRegion(*this, regionPos); }
+    std::size_t unloadRegion(const glm::ivec3& regionPos) { return residency.evictRegion(*this, regionPos); }
+    std::size_t loadRegion(const glm::ivec3& regionPos) { return residency.restoreRegion(*this, regionPos); }
+    // Compresses a region into a read-only SparseVoxelDag and unloads its chunks,
+    // for far terrain that only needs getVoxel and raycast. Chunks carrying light
+    // or damage stay loaded, as the DAG keeps materials only. deactivateVoxel in a
+    // frozen region thaws it first: thawRegion rebuilds its chunks from the DAG,
+    // as edited as they were. Each returns the number of chunks it handled.
+    std::size_t freezeRegion(const glm::ivec3& regionPos);
+    std::size_t thawRegion(const glm::ivec3& regionPos);
+    bool isFrozen(const glm::ivec3& regionPos) const { return frozenRegions.find(regionPos) != nullptr; }
+
+    // Edits through getChunk/getOrCreateChunk stay private to the main thread until the
+    // chunk is published; deactivateVoxel and generateTerrain publish their own edits
+    VoxelChunk* getChunk(const glm::ivec3& chunkPos) const;
+    VoxelChunk& getOrCreateChunk(const glm::ivec3& chunkPos);
+    // Like getChunk, but counts as an access and restores evicted chunks
+    VoxelChunk* loadChunk(const glm::ivec3& chunkPos) { return residency.lookup(*this, chunkPos); }
+    // Removes the chunk; it returns to the pool at the next chunks.reclaim() (done by
+    // trimToBudget). False if it was not loaded
+    bool unloadChunk(const glm::ivec3& chunkPos);
+    // Loaded face neighbours for meshing, in FaceDirection order. Evicted ones are
+    // not restored but stood in for per unloadedNeighbours; missing ones are null.
+    // Loading or unloading a chunk marks the borders facing it stale.
+    VoxelChunk::Neighbours neighboursOf(const glm::ivec3& chunkPos) const;
+
     // You can add more methods for generating different terrains, adding/removing voxels, etc.
+
+private:
+    // Settings of the last generateTerrain, kept so evicted chunks can be regenerated
+    int terrainWidth = 0, terrainDepth = 0, terrainMaxHeight = 0;
+
+    struct FrozenRegion {
+        SparseVoxelDag dag;
+        std::bitset<ChunkPool::REGION_CHUNKS> unsaved; // By local chunk position, x, y, z order
+    };
+    MortonHashMap<std::unique_ptr<FrozenRegion>> frozenRegions; // Keyed by region position
+
+    int terrainHeight(int x, int z) const;
+    // Marks the borders the six loaded neighbours have towards chunkPos stale
+    void invalidateNeighbourBorders(const glm::ivec3& chunkPos);
 };
 
 #endif